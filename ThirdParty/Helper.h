@@ -41,6 +41,12 @@ public:
 	/* Depending on whether or not an autograder is testing it. */
 	inline static bool _autograder_mode = false;
 
+	/* Headless and fixed-length runs (software backend, max_frames) skip the 16ms frame pacing as well. */
+	inline static bool _unpaced_mode = false;
+
+	/* Set when the engine writes the recorded frames itself (asynchronously), Helper then only presents. */
+	inline static bool _external_frame_capture = false;
+
 	/* One way the autograder gauges success is by comparing your "frames" (renderings) to */
 	/* that of a staff solution program fed the exact same input. These are placed into a "frames" folder. */
 	inline static std::string frame_directory_relative_path = "frames";
@@ -48,8 +54,14 @@ public:
 	/* The frame_number advances with every call to Helper::SDL_RenderPresent() */
 	static inline int frame_number = 0;
 	static inline Uint32 current_frame_start_timestamp = 0;
+
+	/* How long the last Helper::SDL_RenderPresent() slept to pace the frame, in SDL performance counter ticks. */
+	static inline Uint64 last_delay_ticks = 0;
 	static int GetFrameNumber() { return frame_number; }
 
+	/* Whether Helper::SDL_RenderPresent() writes every frame into the frames folder (recording or autograder runs). */
+	static bool IsRecordingFrames() { return RECORDING_MODE || IsAutograderMode(); }
+
 	static SDL_Window* SDL_CreateWindow(const char* title, int x, int y, int w, int h, Uint32 flags)
 	{
 		if (IsAutograderMode())
@@ -121,16 +133,20 @@ public:
 			}
 
 			/* Read the current renderer's data and persist it as a .bmp file to disk (BMP format is fast-to-write compared to PNG). */
-			if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_RGB24, saving_surface->pixels, saving_surface->pitch) != 0) {
-				SDL_Log("SDL_RenderReadPixels() failed: %s", SDL_GetError());
-			}
-			std::stringstream filenameStream;
-			filenameStream << "frame_" << std::setw(5) << std::setfill('0') << frame_number << ".bmp";
-			std::string output_file_name = filenameStream.str();
-			std::string output_file_path = frame_directory_relative_path + "/" + output_file_name;
+			/* Skipped when the engine has already read the frame back and queued it for its own writer thread. */
+			if (!_external_frame_capture)
+			{
+				if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_RGB24, saving_surface->pixels, saving_surface->pitch) != 0) {
+					SDL_Log("SDL_RenderReadPixels() failed: %s", SDL_GetError());
+				}
+				std::stringstream filenameStream;
+				filenameStream << "frame_" << std::setw(5) << std::setfill('0') << frame_number << ".bmp";
+				std::string output_file_name = filenameStream.str();
+				std::string output_file_path = frame_directory_relative_path + "/" + output_file_name;
 
-			if (SDL_SaveBMP(saving_surface, output_file_path.c_str()) != 0) {
-				SDL_Log("SDL_SaveBMP() failed: %s", SDL_GetError());
+				if (SDL_SaveBMP(saving_surface, output_file_path.c_str()) != 0) {
+					SDL_Log("SDL_SaveBMP() failed: %s", SDL_GetError());
+				}
 			}
 		}
 
@@ -402,9 +418,10 @@ private:
 	/* If the engine detects it is being autograded, it will run as fast as possible. */
 	static void SDL_Delay() {
 
-		if (_autograder_mode)
+		if (_autograder_mode || _unpaced_mode)
 		{
 			//::SDL_Delay(1); Don't bother delaying at all. Gotta go fast when autograding.
+			last_delay_ticks = 0;
 		}
 		else
 		{
@@ -414,7 +431,9 @@ private:
 
 			int delay_ticks = std::max(static_cast<int>(desired_frame_duration_milliseconds) - static_cast<int>(current_frame_duration_milliseconds), 1);
 
+			Uint64 delay_start = SDL_GetPerformanceCounter();
 			::SDL_Delay(delay_ticks);
+			last_delay_ticks = SDL_GetPerformanceCounter() - delay_start;
 		}
 
 		current_frame_start_timestamp = SDL_GetTicks();  // Record start time of the frame
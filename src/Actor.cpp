@@ -7,6 +7,11 @@
 #include "EngineUtils.h"
 #include "Rigidbody.h"
 #include "ParticleSystem.h"
+#include "Tilemap.h"
+#include "ActorPool.h"
+#include "ComponentRegistry.h"
+#include "TagDB.h"
+#include "TemplateDB.h"
 #include <memory>
 
 Actor::Actor() {
@@ -19,20 +24,25 @@ void Actor::Start() {
 	}
 
 	// run each component
-	for (std::shared_ptr<Component> c : OnStartComponentQueue) {
+	int error_handler = ComponentManager::PushErrorHandler();
+	for (int slot : OnStartComponentQueue) {
+		Component& c = component_pool[slot];
 		try {
-			if (c && c->isEnabled()) {
-				luabridge::LuaRef* ref = c->componentRef.get();
-				if (c->type == "Rigidbody") {
-					Rigidbody* r = ref->cast<Rigidbody*>();
+			if (c.isEnabled()) {
+				if (c.type_id == COMPONENT_TYPE_RIGIDBODY) {
+					Rigidbody* r = static_cast<Rigidbody*>(c.native);
 					r->OnStart();
 				}
-				else if (c->type == "ParticleSystem") {
-					ParticleSystem* p = ref->cast<ParticleSystem*>();
+				else if (c.type_id == COMPONENT_TYPE_PARTICLE_SYSTEM) {
+					ParticleSystem* p = static_cast<ParticleSystem*>(c.native);
 					p->OnStart();
 				}
+				else if (c.type_id == COMPONENT_TYPE_TILEMAP) {
+					Tilemap* t = static_cast<Tilemap*>(c.native);
+					t->OnStart();
+				}
 				else {
-					(*ref)["OnStart"](*ref);
+					ComponentManager::CallLifecycle(c.lifecycle->on_start, c, name, error_handler);
 				}
 			}
 		}
@@ -40,25 +50,31 @@ void Actor::Start() {
 			EngineUtils::ReportError(name, e);
 		}
 	}
+	lua_settop(ComponentManager::lua_state, error_handler - 1);
 	OnStartComponentQueue.clear();
 }
 
-void Actor::Update() {
+void Actor::Update(bool include_lua) {
 	if (OnUpdateComponentQueue.empty()) {
 		return;
 	}
 
 	// run each component's update function
-	for (std::shared_ptr<Component> c : OnUpdateComponentQueue) {
+	int error_handler = ComponentManager::PushErrorHandler();
+	for (int slot : OnUpdateComponentQueue) {
+		Component& c = component_pool[slot];
 		try {
-			if (c && c->isEnabled()) {
-				luabridge::LuaRef* ref = c->componentRef.get();
-				if (c->type == "ParticleSystem") {
-					ParticleSystem* p = ref->cast<ParticleSystem*>();
+			if (c.isEnabled()) {
+				if (c.type_id == COMPONENT_TYPE_PARTICLE_SYSTEM) {
+					ParticleSystem* p = static_cast<ParticleSystem*>(c.native);
 					p->OnUpdate();
 				}
-				else {
-					(*ref)["OnUpdate"](*ref);
+				else if (c.type_id == COMPONENT_TYPE_TILEMAP) {
+					Tilemap* t = static_cast<Tilemap*>(c.native);
+					t->OnUpdate();
+				}
+				else if (include_lua) {
+					ComponentManager::CallLifecycle(c.lifecycle->on_update, c, name, error_handler);
 				}
 			}
 		}
@@ -66,6 +82,7 @@ void Actor::Update() {
 			EngineUtils::ReportError(name, e);
 		}
 	}
+	lua_settop(ComponentManager::lua_state, error_handler - 1);
 }
 
 void Actor::LateUpdate() {
@@ -73,323 +90,302 @@ void Actor::LateUpdate() {
 		return;
 	}
 	// run each component's update function
-	for (std::shared_ptr<Component> c : OnLateUpdateComponentQueue) {
-		try {
-			if (c && c->isEnabled()) {
-				luabridge::LuaRef* ref = c->componentRef.get();
-				(*ref)["OnLateUpdate"](*ref);
-			}
-		}
-		catch (luabridge::LuaException e) {
-			EngineUtils::ReportError(name, e);
+	int error_handler = ComponentManager::PushErrorHandler();
+	for (int slot : OnLateUpdateComponentQueue) {
+		Component& c = component_pool[slot];
+		if (c.isEnabled()) {
+			ComponentManager::CallLifecycle(c.lifecycle->on_late_update, c, name, error_handler);
 		}
 	}
+	lua_settop(ComponentManager::lua_state, error_handler - 1);
 }
 
-void Actor::AddComponentToQueues(Component& c) {
+void Actor::AddComponentToQueues(int slot) {
+	Component& c = component_pool[slot];
 	// Handle rigidbody separately, called only during runtime
-	if (c.type == "Rigidbody") {
+	if (c.type_id == COMPONENT_TYPE_RIGIDBODY) {
 		c.hasStart = true;
 		c.hasDestroy = true;
-		OnStartComponentQueue.push_back(std::make_shared<Component>(c));
-		OnDeleteQueue.push_back(std::make_shared<Component>(c));
+		OnStartComponentQueue.push_back(slot);
+		OnDeleteQueue.push_back(slot);
 		return;
 	}
 	// Handle separately, called only during runtime
-	if (c.type == "ParticleSystem") {
+	if (c.type_id == COMPONENT_TYPE_PARTICLE_SYSTEM) {
 		c.hasStart = true;
 		c.hasUpdate = true;
 		//c.hasDestroy = true;
-		OnStartComponentQueue.push_back(std::make_shared<Component>(c));
-		OnUpdateComponentQueue.push_back(std::make_shared<Component>(c));
-		//OnDeleteQueue.push_back(std::make_shared<Component>(c));
+		OnStartComponentQueue.push_back(slot);
+		OnUpdateComponentQueue.push_back(slot);
+		//OnDeleteQueue.push_back(slot);
+		return;
+	}
+	// Handle separately, called only during runtime
+	if (c.type_id == COMPONENT_TYPE_TILEMAP) {
+		c.hasStart = true;
+		c.hasUpdate = true;
+		OnStartComponentQueue.push_back(slot);
+		OnUpdateComponentQueue.push_back(slot);
 		return;
 	}
+	// Nothing to call, and a data-only component may not even have its table yet
+	if (ComponentDB::IsDataOnly(c.type_id)) {
+		return;
+	}
+
+	// Resolve lifecycle functions once, later changes to them on the instance are not picked up
+	if (!c.lifecycle) {
+		c.lifecycle = std::make_shared<LifecycleRefs>();
+		c.lifecycle->on_start = ComponentManager::RefFunction(*c.componentRef, "OnStart");
+		c.lifecycle->on_update = ComponentManager::RefFunction(*c.componentRef, "OnUpdate");
+		c.lifecycle->on_late_update = ComponentManager::RefFunction(*c.componentRef, "OnLateUpdate");
+	}
 
 	// Queue component for OnStart function next update (frame)
-	if ((*c.componentRef)["OnStart"].isFunction()) {
-		OnStartComponentQueue.push_back(std::make_shared<Component>(c));
+	if (c.lifecycle->on_start != LUA_NOREF) {
 		c.hasStart = true;
+		OnStartComponentQueue.push_back(slot);
 	}
 
 	// Queue component for OnUpdate function
-	if ((*c.componentRef)["OnUpdate"].isFunction()) {
-		OnUpdateComponentQueue.push_back(std::make_shared<Component>(c));
+	if (c.lifecycle->on_update != LUA_NOREF) {
 		c.hasUpdate = true;
+		OnUpdateComponentQueue.push_back(slot);
 	}
 
 	// Queue component for LateUpdate
-	if ((*c.componentRef)["OnLateUpdate"].isFunction()) {
-		OnLateUpdateComponentQueue.push_back(std::make_shared<Component>(c));
+	if (c.lifecycle->on_late_update != LUA_NOREF) {
 		c.hasLateUpdate = true;
+		OnLateUpdateComponentQueue.push_back(slot);
 	}
 
 	if ((*c.componentRef)["OnCollisionEnter"].isFunction() || (*c.componentRef)["OnCollisionExit"].isFunction()) {
-		OnCollisionQueue.push_back(std::make_shared<Component>(c));
+		OnCollisionQueue.push_back(slot);
 	}
 	if ((*c.componentRef)["OnTriggerEnter"].isFunction() || (*c.componentRef)["OnTriggerExit"].isFunction()) {
-		OnTriggerQueue.push_back(std::make_shared<Component>(c));
+		OnTriggerQueue.push_back(slot);
 	}
 
 	// Queue component for OnDestroy lifecycle function
 	if ((*c.componentRef)["OnDestroy"].isFunction()) {
 		c.hasDestroy = true;
-		OnDeleteQueue.push_back(std::make_shared<Component>(c));
+		OnDeleteQueue.push_back(slot);
 	}
 }
 
-
-// We use a separate derived class for Rigidbody
-void Actor::CreateRigidbody(rapidjson::Value::ConstMemberIterator compItr, std::string name) {
-	auto itr = components.find(name);
-	Rigidbody* r = new Rigidbody();
-	Component c;
-	if (itr != components.end()) {
-		c = *itr->second; // this component already exists (by key, not type)
-	}
-	else {
-		// init a rigidbody from the value
-		c = ComponentManager::MakeInstance("Rigidbody", name);
-	}
-	// Init Rigidbody
-	if (compItr->value.HasMember("x") ) {
-		r->x = compItr->value["x"].GetFloat();
-	}
-	if (compItr->value.HasMember("y")) {
-		r->y = compItr->value["y"].GetFloat();
-	}
-	if (compItr->value.HasMember("body_type")) {
-		r->body_type = compItr->value["body_type"].GetString();
-	}
-	if (compItr->value.HasMember("precise")) {
-		r->precise = compItr->value["precise"].GetBool();
-	}
-	if (compItr->value.HasMember("gravity_scale")) {
-		r->gravity_scale = compItr->value["gravity_scale"].GetFloat();
-	}
-	if (compItr->value.HasMember("density")) {
-		r->density = compItr->value["density"].GetFloat();
-	}
-	if (compItr->value.HasMember("angular_friction")) {
-		r->angular_friction = compItr->value["angular_friction"].GetFloat();
-	}
-	if (compItr->value.HasMember("rotation")) {
-		r->rotation = compItr->value["rotation"].GetFloat();
-	}
-	if (compItr->value.HasMember("has_collider")) {
-		r->has_collider = compItr->value["has_collider"].GetBool();
-	}
-	if (compItr->value.HasMember("has_trigger")) {
-		r->has_trigger = compItr->value["has_trigger"].GetBool();
-	}
-	if (compItr->value.HasMember("collider_type")) {
-		r->collider_type = compItr->value["collider_type"].GetString();
+void Actor::RemoveComponentsFromQueues(const std::vector<int>& slots) {
+	if (slots.empty()) {
+		return;
 	}
-	if (compItr->value.HasMember("width")) {
-		r->width = compItr->value["width"].GetFloat();
+	std::vector<bool> removed(component_pool.size(), false);
+	for (int slot : slots) {
+		removed[slot] = true;
 	}
-	if (compItr->value.HasMember("height")) {
-		r->height = compItr->value["height"].GetFloat();
+	for (std::vector<int>* queue : { &OnStartComponentQueue, &OnUpdateComponentQueue, &OnLateUpdateComponentQueue, &OnCollisionQueue, &OnTriggerQueue, &OnDeleteQueue }) {
+		queue->erase(std::remove_if(queue->begin(), queue->end(), [&removed](int slot) {
+			return removed[slot]; }), queue->end());
 	}
-	if (compItr->value.HasMember("radius")) {
-		r->radius = compItr->value["radius"].GetFloat();
+}
+
+void Actor::ResetQueues() {
+	for (std::vector<int>* queue : { &OnStartComponentQueue, &OnUpdateComponentQueue, &OnLateUpdateComponentQueue, &OnCollisionQueue, &OnTriggerQueue, &OnDeleteQueue }) {
+		queue->clear();
 	}
-	if (compItr->value.HasMember("friction")) {
-		r->friction = compItr->value["friction"].GetFloat();
+	for (const auto& [key, slot] : components) {
+		AddComponentToQueues(slot);
 	}
-	if (compItr->value.HasMember("bounciness")) {
-		r->bounciness = compItr->value["bounciness"].GetFloat();
+	SortQueue(OnStartComponentQueue);
+	SortQueue(OnUpdateComponentQueue);
+	SortQueue(OnLateUpdateComponentQueue);
+	SortQueue(OnCollisionQueue);
+	SortQueue(OnTriggerQueue);
+	SortQueue(OnDeleteQueue);
+}
+
+int Actor::AddToPool(const Component& c) {
+	if (!free_component_slots.empty()) {
+		int slot = free_component_slots.back();
+		free_component_slots.pop_back();
+		component_pool[slot] = c;
+		return slot;
 	}
-	if (compItr->value.HasMember("trigger_type")) {
-		r->trigger_type = compItr->value["trigger_type"].GetString();
+	component_pool.push_back(c);
+	return static_cast<int>(component_pool.size()) - 1;
+}
+
+void Actor::FreeSlot(int slot) {
+	ComponentDB::UntrackInstance(&component_pool[slot]);
+	component_pool[slot] = Component();
+	free_component_slots.push_back(slot);
+}
+
+void Actor::InsertComponent(const std::string& key, int slot) {
+	if (!components.insert(std::make_pair(key, slot)).second) {
+		return;
 	}
-	if (compItr->value.HasMember("trigger_radius")) {
-		r->trigger_radius = compItr->value["trigger_radius"].GetFloat();
+	int type_id = component_pool[slot].type_id;
+	if (type_id < 0) {
+		return;
 	}
-	if (compItr->value.HasMember("trigger_height")) {
-		r->trigger_height = compItr->value["trigger_height"].GetFloat();
+	if (type_id >= static_cast<int>(components_by_type.size())) {
+		components_by_type.resize(ComponentDB::GetTypeCount());
 	}
-	if (compItr->value.HasMember("trigger_width")) {
-		r->trigger_width = compItr->value["trigger_width"].GetFloat();
+	std::vector<int>& of_type = components_by_type[type_id];
+	auto position = std::lower_bound(of_type.begin(), of_type.end(), key, [this](int other, const std::string& k) {
+		return component_pool[other].key < k; });
+	of_type.insert(position, slot);
+
+	if (of_type.size() == 1) {
+		if (type_id / 64 >= static_cast<int>(component_mask.size())) {
+			component_mask.resize(type_id / 64 + 1);
+		}
+		component_mask[type_id / 64] |= uint64_t(1) << (type_id % 64);
+		ComponentRegistry::Add(this, type_id);
 	}
+}
 
-	// set Rigidbody as LuaRef
-	c.componentRef = std::make_shared<luabridge::LuaRef>(luabridge::LuaRef(ComponentManager::lua_state, r));
-	c.hasDestroy = true;
+void Actor::EraseComponent(const std::string& key) {
+	auto itr = components.find(key);
 	if (itr == components.end()) {
-		// This is a new component, so inject the convenience references
-		r->actor = this;
-		r->key = name;
-		r->type = "Rigidbody";
-		r->enabled = true;
-		// Insert a shared pointer of the component into map
-		components.insert(std::make_pair(name, std::make_shared<Component>(c)));
-		//AddComponentToQueues(c);
+		return;
+	}
+	int slot = itr->second;
+	components.erase(itr);
+	int type_id = component_pool[slot].type_id;
+	if (type_id >= 0 && type_id < static_cast<int>(components_by_type.size())) {
+		std::vector<int>& of_type = components_by_type[type_id];
+		of_type.erase(std::remove(of_type.begin(), of_type.end(), slot), of_type.end());
 
-		// push it into the OnStart queue
-		OnStartComponentQueue.push_back(std::make_shared<Component>(c));
-		c.hasStart = true;
+		if (of_type.empty()) {
+			component_mask[type_id / 64] &= ~(uint64_t(1) << (type_id % 64));
+			ComponentRegistry::Remove(this, type_id);
+		}
 	}
 }
 
+void Actor::SortQueue(std::vector<int>& queue) {
+	std::sort(queue.begin(), queue.end(), [this](int a, int b) {
+		return component_pool[a].key < component_pool[b].key; });
+}
+
+
+// Adds a native component that already holds its values under [key]
+template <class T>
+void Actor::AddNativeComponent(T* native, const std::string& type_name, const std::string& key) {
+	// Inject the convenience references
+	native->actor = this;
+	native->key = key;
+	native->type = type_name;
+	native->enabled = true;
+	Component c = ComponentManager::MakeInstance(type_name, key);
+	// The Lua proxy is made by GetProxy if a script ever asks for the component
+	c.native = native;
+	c.native_enabled = &native->enabled;
+	// Store the component once, the map and queues refer to its slot
+	int slot = AddToPool(c);
+	InsertComponent(key, slot);
+	AddComponentToQueues(slot);
+}
 
 // We use a separate derived class for Rigidbody
-void Actor::CreateParticleSystem(rapidjson::Value::ConstMemberIterator compItr, std::string name) {
+void Actor::CreateRigidbody(rapidjson::Value::ConstMemberIterator compItr, std::string name) {
 	auto itr = components.find(name);
-	ParticleSystem* p = new ParticleSystem();
-	Component c;
 	if (itr != components.end()) {
-		c = *itr->second; // this component already exists (by key, not type)
-	}
-	else {
-		// init a particlesystem from the value
-		c = ComponentManager::MakeInstance("ParticleSystem", name);
-	}
-	// Init Rigidbody
-	if (compItr->value.HasMember("x")) {
-		p->x = compItr->value["x"].GetFloat();
-	}
-	if (compItr->value.HasMember("y")) {
-		p->y = compItr->value["y"].GetFloat();
-	}
-	if (compItr->value.HasMember("frames_between_bursts")) {
-		p->frames_between_bursts = compItr->value["frames_between_bursts"].GetInt();
-		// Ensure the frames between bursts is at least 1
-		if (p->frames_between_bursts < 1) {
-			p->frames_between_bursts = 1;
-		}
-	}
-	if (compItr->value.HasMember("burst_quantity")) {
-		p->burst_quantity = compItr->value["burst_quantity"].GetInt();
-		// Ensure the frames between bursts is at least 1
-		if (p->burst_quantity < 1) {
-			p->burst_quantity = 1;
+		// this component already exists (by key, not type), the values override it
+		Component& c = component_pool[itr->second];
+		if (c.type_id == COMPONENT_TYPE_RIGIDBODY) {
+			static_cast<Rigidbody*>(c.native)->ReadValues(compItr->value);
 		}
+		return;
 	}
-	if (compItr->value.HasMember("start_scale_min")) {
-		p->start_scale_min = compItr->value["start_scale_min"].GetFloat();
-	}
-	if (compItr->value.HasMember("start_scale_max")) {
-		p->start_scale_max = compItr->value["start_scale_max"].GetFloat();
-	}
-	if (compItr->value.HasMember("rotation_min")) {
-		p->rotation_min = compItr->value["rotation_min"].GetFloat();
-	}
-	if (compItr->value.HasMember("rotation_max")) {
-		p->rotation_max = compItr->value["rotation_max"].GetFloat();
-	}
-	if (compItr->value.HasMember("emit_radius_min")) {
-		p->emit_radius_min = compItr->value["emit_radius_min"].GetFloat();
-	}
-	if (compItr->value.HasMember("emit_radius_max")) {
-		p->emit_radius_max = compItr->value["emit_radius_max"].GetFloat();
-	}
-	if (compItr->value.HasMember("emit_angle_min")) {
-		p->emit_angle_min = compItr->value["emit_angle_min"].GetFloat();
-	}
-	if (compItr->value.HasMember("emit_angle_max")) {
-		p->emit_angle_max = compItr->value["emit_angle_max"].GetFloat();
-	}
-	
-	if (compItr->value.HasMember("start_color_r")) {
-		p->start_color_r = compItr->value["start_color_r"].GetInt();
-	}
-	if (compItr->value.HasMember("start_color_g")) {
-		p->start_color_g = compItr->value["start_color_g"].GetInt();
-	}
-	if (compItr->value.HasMember("start_color_b")) {
-		p->start_color_b = compItr->value["start_color_b"].GetInt();
-	}
-	if (compItr->value.HasMember("start_color_a")) {
-		p->start_color_a = compItr->value["start_color_a"].GetInt();
-	}
-	if (compItr->value.HasMember("end_color_r")) {
-		p->end_color_r = static_cast<int>(compItr->value["end_color_r"].GetFloat());
-		p->has_end_color = true;
-	}
-	if (compItr->value.HasMember("end_color_g")) {
-		p->end_color_g = static_cast<int>(compItr->value["end_color_g"].GetFloat());
-		p->has_end_color = true;
-	}
-	if (compItr->value.HasMember("end_color_b")) {
-		p->end_color_b = static_cast<int>(compItr->value["end_color_b"].GetFloat());
-		p->has_end_color = true;
-	}
-	if (compItr->value.HasMember("end_color_a")) {
-		p->end_color_a = static_cast<int>(compItr->value["end_color_a"].GetFloat());
-		p->has_end_color = true;
-	}
+	Rigidbody* r = new Rigidbody();
+	r->ReadValues(compItr->value);
+	AddNativeComponent(r, "Rigidbody", name);
+}
 
-	if (compItr->value.HasMember("image")) {
-		p->image = compItr->value["image"].GetString();
+void Actor::CreateParticleSystem(rapidjson::Value::ConstMemberIterator compItr, std::string name) {
+	auto itr = components.find(name);
+	if (itr != components.end()) {
+		// this component already exists (by key, not type), the values override it
+		Component& c = component_pool[itr->second];
+		if (c.type_id == COMPONENT_TYPE_PARTICLE_SYSTEM) {
+			static_cast<ParticleSystem*>(c.native)->ReadValues(compItr->value);
+		}
+		return;
 	}
+	ParticleSystem* p = new ParticleSystem();
+	p->ReadValues(compItr->value);
+	AddNativeComponent(p, "ParticleSystem", name);
+}
 
-	if (compItr->value.HasMember("duration_frames")) {
-		p->duration_frames = compItr->value["duration_frames"].GetInt();
-		if (p->duration_frames < 1) {
-			p->duration_frames = 1;
+// Tilemaps are native as well, rendering their tiles as batched geometry
+void Actor::CreateTilemap(rapidjson::Value::ConstMemberIterator compItr, std::string name) {
+	auto itr = components.find(name);
+	if (itr != components.end()) {
+		// this component already exists (by key, not type), the values override it
+		Component& c = component_pool[itr->second];
+		if (c.type_id == COMPONENT_TYPE_TILEMAP) {
+			static_cast<Tilemap*>(c.native)->ReadValues(compItr->value);
 		}
+		return;
 	}
-	if (compItr->value.HasMember("start_speed_min")) {
-		p->start_speed_min = compItr->value["start_speed_min"].GetFloat();
-	}
-	if (compItr->value.HasMember("start_speed_max")) {
-		p->start_speed_max = compItr->value["start_speed_max"].GetFloat();
-	}
-	if (compItr->value.HasMember("rotation_speed_min")) {
-		p->rotation_speed_min = compItr->value["rotation_speed_min"].GetFloat();
-	}
-	if (compItr->value.HasMember("rotation_speed_max")) {
-		p->rotation_speed_max = compItr->value["rotation_speed_max"].GetFloat();
-	}
-	if (compItr->value.HasMember("gravity_scale_x")) {
-		p->gravity_scale_x = compItr->value["gravity_scale_x"].GetFloat();
-	}
-	if (compItr->value.HasMember("gravity_scale_y")) {
-		p->gravity_scale_y = compItr->value["gravity_scale_y"].GetFloat();
-	}
-	if (compItr->value.HasMember("drag_factor")) {
-		p->drag_factor = compItr->value["drag_factor"].GetFloat();
-	}
-	if (compItr->value.HasMember("angular_drag_factor")) {
-		p->angular_drag_factor = compItr->value["angular_drag_factor"].GetFloat();
-	}
-	if (compItr->value.HasMember("end_scale")) {
-		p->end_scale = compItr->value["end_scale"].GetFloat();
-		p->has_end_scale = true;
-	}
-	if (compItr->value.HasMember("sorting_order")) {
-		p->sorting_order = compItr->value["sorting_order"].GetInt();
-	}
-
-
-
-	// set Rigidbody as LuaRef
-	c.componentRef = std::make_shared<luabridge::LuaRef>(luabridge::LuaRef(ComponentManager::lua_state, p));
-	if (itr == components.end()) {
-		// This is a new component, so inject the convenience references
-		p->actor = this;
-		p->key = name;
-		p->type = "ParticleSystem";
-		p->enabled = true;
-		// Insert a shared pointer of the component into map
-		components.insert(std::make_pair(name, std::make_shared<Component>(c)));
-
-		c.hasStart = true;
-		c.hasUpdate = true;
-		//c.hasDestroy = true;
-		// push it into the OnStart queue
-		OnStartComponentQueue.push_back(std::make_shared<Component>(c));
-		OnUpdateComponentQueue.push_back(std::make_shared<Component>(c));
+	Tilemap* t = new Tilemap();
+	t->ReadValues(compItr->value);
+	AddNativeComponent(t, "Tilemap", name);
+}
 
+void Actor::ReadDataOnlyFields(Component& c, const rapidjson::Value& value) {
+	if (!c.fields) {
+		c.fields = std::make_shared<std::vector<ComponentField>>();
+	}
+	// The same values CreateComponent would set on a table
+	for (auto varItr = value.MemberBegin(); varItr != value.MemberEnd(); varItr++) {
+		ComponentField field = { varItr->name.GetString(), false };
+		if (varItr->value.IsString()) {
+			field.value = std::string(varItr->value.GetString());
+		}
+		else if (varItr->value.IsBool()) {
+			field.value = varItr->value.GetBool();
+		}
+		else if (varItr->value.IsInt()) {
+			field.value = varItr->value.GetInt();
+		}
+		else if (varItr->value.IsFloat()) {
+			field.value = varItr->value.GetFloat();
+		}
+		else {
+			continue;
+		}
+		if (field.name == "enabled") {
+			// Any value but false is truthy in Lua
+			c.enabled = !std::holds_alternative<bool>(field.value) || std::get<bool>(field.value);
+		}
+		c.fields->push_back(field);
 	}
 }
 
 void Actor::CreateComponent(rapidjson::Value::ConstMemberIterator compItr, std::string type, std::string name) {
 	auto itr = components.find(name);
+	if (itr != components.end()) {
+		Component& existing = component_pool[itr->second];
+		if (!existing.componentRef && ComponentDB::IsDataOnly(existing.type_id)) {
+			// Still without a table, so the scene's values wait with the template's
+			ReadDataOnlyFields(existing, compItr->value);
+			return;
+		}
+	}
+	else if (ComponentDB::IsDataOnly(ComponentDB::GetTypeID(type))) {
+		Component c = Component(type);
+		c.key = name;
+		c.type_id = ComponentDB::GetTypeID(type);
+		ReadDataOnlyFields(c, compItr->value);
+		InsertComponent(name, AddToPool(c));
+		return;
+	}
 	Component c;
 	if (itr != components.end()) {
-		c = *itr->second; // this component already exists (by key, not type)
+		GetProxy(component_pool[itr->second]);
+		c = component_pool[itr->second]; // this component already exists (by key, not type)
 	}
 	else {
 		c = ComponentManager::MakeInstance(type, name); // this component doesn't exist, so make a new one
@@ -415,9 +411,16 @@ void Actor::CreateComponent(rapidjson::Value::ConstMemberIterator compItr, std::
 	if (itr == components.end()) {
 		// This is a new component, so inject the convenience references
 		InjectConvenienceReferences(ref);
-		// Insert a shared pointer of the component into map
-		AddComponentToQueues(c);
-		components.insert(std::make_pair(name, std::make_shared<Component>(c)));
+		// Store the component once, the map and queues refer to its slot
+		int slot = AddToPool(c);
+		component_pool[slot].enabled = (*ref)["enabled"];
+		ComponentDB::TrackInstance(component_pool[slot]);
+		AddComponentToQueues(slot);
+		InsertComponent(name, slot);
+	}
+	else {
+		// The json may have set "enabled", read it once here instead of every frame
+		component_pool[itr->second].enabled = (*ref)["enabled"];
 	}
 }
 
@@ -435,6 +438,9 @@ void Actor::CreateComponents(const rapidjson::Value& comp_arr) {
 		else if (type == "ParticleSystem") {
 			CreateParticleSystem(compItr, componentName);
 		}
+		else if (type == "Tilemap") {
+			CreateTilemap(compItr, componentName);
+		}
 		else {
 			CreateComponent(compItr, type, componentName);
 		}
@@ -449,15 +455,117 @@ void Actor::CreateActorFromValue(rapidjson::Value& arr) {
 		if (key == "name") {
 			name = value.GetString();
 		}
+		if (key == "tags") {
+			// Template tags are kept, scene tags add to them
+			tags |= TagDB::ParseMask(value);
+		}
 		if (key == "components" && itr->value.IsObject()) {
 			CreateComponents(value);
 		}
 	}
 	// Sort our queues so we don't have to every time we use them
-	std::sort(OnStartComponentQueue.begin(), OnStartComponentQueue.end(), ComponentManager::CompareComponents);
-	std::sort(OnUpdateComponentQueue.begin(), OnUpdateComponentQueue.end(), ComponentManager::CompareComponents);
-	std::sort(OnLateUpdateComponentQueue.begin(), OnLateUpdateComponentQueue.end(), ComponentManager::CompareComponents);
-	std::sort(OnDeleteQueue.begin(), OnDeleteQueue.end(), ComponentManager::CompareComponents);
+	SortQueue(OnStartComponentQueue);
+	SortQueue(OnUpdateComponentQueue);
+	SortQueue(OnLateUpdateComponentQueue);
+	SortQueue(OnDeleteQueue);
+}
+
+void Actor::CreateFromPrototype(const TemplatePrototype& prototype) {
+	name = prototype.name;
+	tags |= prototype.tags;
+
+	lua_State* lua_state = ComponentManager::lua_state;
+	// In key order, so every queue comes out sorted without sorting it
+	for (int index : prototype.by_key) {
+		const ComponentPrototype& component = prototype.components[index];
+		if (component.rigidbody) {
+			AddNativeComponent(new Rigidbody(*component.rigidbody), "Rigidbody", component.key);
+		}
+		else if (component.particle_system) {
+			AddNativeComponent(new ParticleSystem(*component.particle_system), "ParticleSystem", component.key);
+		}
+		else if (component.tilemap) {
+			AddNativeComponent(new Tilemap(*component.tilemap), "Tilemap", component.key);
+		}
+		else if (!component.fields) {
+			// Reports the missing component type
+			ComponentManager::MakeInstance(component.type, component.key);
+		}
+		else if (ComponentDB::IsDataOnly(component.type_id)) {
+			// Nothing for the engine to call, so it stays the template's fields until a script asks for it
+			Component c = Component(component.type);
+			c.key = component.key;
+			c.type_id = component.type_id;
+			c.prototype = &component;
+			c.enabled = component.enabled;
+			InsertComponent(component.key, AddToPool(c));
+		}
+		else {
+			Component c = Component(component.type);
+			c.key = component.key;
+			c.type_id = component.type_id;
+
+			// Clone the fields in C, the metatable is shared by the whole type
+			lua_createtable(lua_state, 0, component.field_count);
+			component.fields->push(lua_state);
+			ComponentManager::CopyFields(-1, -2);
+			lua_pop(lua_state, 1);
+			ComponentDB::SetInstanceMetatable(lua_state, component.type_id);
+			c.componentRef = std::make_shared<luabridge::LuaRef>(luabridge::LuaRef::fromStack(lua_state, -1));
+			lua_pop(lua_state, 1);
+
+			InjectConvenienceReferences(c.componentRef);
+			// Store the component once, the map and queues refer to its slot
+			int slot = AddToPool(c);
+			component_pool[slot].enabled = (*c.componentRef)["enabled"];
+			ComponentDB::TrackInstance(component_pool[slot]);
+			AddComponentToQueues(slot);
+			InsertComponent(component.key, slot);
+		}
+	}
+}
+
+luabridge::LuaRef& Actor::GetProxy(Component& c) {
+	if (c.componentRef) {
+		return *c.componentRef;
+	}
+	lua_State* lua_state = ComponentManager::lua_state;
+	if (c.type_id == COMPONENT_TYPE_RIGIDBODY) {
+		c.componentRef = std::make_shared<luabridge::LuaRef>(luabridge::LuaRef(lua_state, static_cast<Rigidbody*>(c.native)));
+	}
+	else if (c.type_id == COMPONENT_TYPE_PARTICLE_SYSTEM) {
+		c.componentRef = std::make_shared<luabridge::LuaRef>(luabridge::LuaRef(lua_state, static_cast<ParticleSystem*>(c.native)));
+	}
+	else if (c.type_id == COMPONENT_TYPE_TILEMAP) {
+		c.componentRef = std::make_shared<luabridge::LuaRef>(luabridge::LuaRef(lua_state, static_cast<Tilemap*>(c.native)));
+	}
+	else {
+		// A data-only component: the template's fields, then the scene's, the way the others are built
+		if (c.prototype) {
+			lua_createtable(lua_state, 0, c.prototype->field_count);
+			c.prototype->fields->push(lua_state);
+			ComponentManager::CopyFields(-1, -2);
+			lua_pop(lua_state, 1);
+		}
+		else {
+			lua_createtable(lua_state, 0, c.fields ? static_cast<int>(c.fields->size()) + 3 : 3);
+		}
+		ComponentDB::SetInstanceMetatable(lua_state, c.type_id);
+		c.componentRef = std::make_shared<luabridge::LuaRef>(luabridge::LuaRef::fromStack(lua_state, -1));
+		lua_pop(lua_state, 1);
+
+		luabridge::LuaRef& ref = *c.componentRef;
+		ref["key"] = c.key;
+		if (c.fields) {
+			for (const ComponentField& field : *c.fields) {
+				std::visit([&ref, &field](const auto& value) { ref[field.name] = value; }, field.value);
+			}
+		}
+		ref["enabled"] = c.enabled;
+		InjectConvenienceReferences(c.componentRef);
+		ComponentDB::TrackInstance(c);
+	}
+	return *c.componentRef;
 }
 
 // ---------- [ LUA RUNTIME FUNCS ] ------
@@ -471,56 +579,78 @@ luabridge::LuaRef Actor::AddComponent(std::string type_name) {
 		Rigidbody* r = new Rigidbody();
 		// set Rigidbody as LuaRef
 		c.componentRef = std::make_shared<luabridge::LuaRef>(luabridge::LuaRef(ComponentManager::lua_state, r));
+		c.native = r;
+		c.native_enabled = &r->enabled;
 		c.hasDestroy = true;
 		// This is a new component, so inject the convenience references
 		r->actor = this;
-		r->key = name;
+		r->key = key;
 		r->type = "Rigidbody";
 		r->enabled = true;
-		// Insert a shared pointer of the component into map
-		components.insert(std::make_pair(name, std::make_shared<Component>(c)));
-
 		c.hasStart = true;
 	}
-	if (type_name == "ParticleSystem") {
+	else if (type_name == "ParticleSystem") {
 		ParticleSystem* p = new ParticleSystem();
 		// set Rigidbody as LuaRef
 		c.componentRef = std::make_shared<luabridge::LuaRef>(luabridge::LuaRef(ComponentManager::lua_state, p));
+		c.native = p;
+		c.native_enabled = &p->enabled;
 		c.hasDestroy = true;
 		// This is a new component, so inject the convenience references
 		p->actor = this;
-		p->key = name;
-		p->type = "Rigidbody";
+		p->key = key;
+		p->type = "ParticleSystem";
 		p->enabled = true;
-		// Insert a shared pointer of the component into map
-		components.insert(std::make_pair(name, std::make_shared<Component>(c)));
-
 		c.hasStart = true;
 	}
+	else if (type_name == "Tilemap") {
+		Tilemap* t = new Tilemap();
+		// set Tilemap as LuaRef
+		c.componentRef = std::make_shared<luabridge::LuaRef>(luabridge::LuaRef(ComponentManager::lua_state, t));
+		c.native = t;
+		c.native_enabled = &t->enabled;
+		// This is a new component, so inject the convenience references
+		t->actor = this;
+		t->key = key;
+		t->type = "Tilemap";
+		t->enabled = true;
+	}
 	else {
 		(*c.componentRef)["enabled"] = true;	
 		// This is a new component, so inject the convenience references
 		InjectConvenienceReferences(c.componentRef);
 	}
-	std::shared_ptr<Component> comp_ptr = std::make_shared<Component>(c);
-	SceneDB::ComponentsToAdd[this].push_back(comp_ptr);
-	SceneDB::ActorsComponentChanged.push_back(this);
+	int slot = AddToPool(c);
+	if (c.type_id == COMPONENT_TYPE_RIGIDBODY || c.type_id == COMPONENT_TYPE_PARTICLE_SYSTEM) {
+		// Visible to GetComponent right away, queued with the rest next frame
+		InsertComponent(key, slot);
+	}
+	else if (c.type_id != COMPONENT_TYPE_TILEMAP) {
+		ComponentDB::TrackInstance(component_pool[slot]);
+	}
+	pending_adds.push_back(slot);
+	SceneDB::QueueComponentChanges(this);
 
 	return *c.componentRef;
 }
 
 void Actor::RemoveComponent(luabridge::LuaRef ref) {
-	ref["enabled"] = false;
-	SceneDB::ComponentsToRemove[this].push_back(ref["key"]);
-	SceneDB::ActorsComponentChanged.push_back(this);
+	Component* c = ComponentDB::FindInstance(ref);
+	if (c != nullptr) {
+		c->SetEnabled(false);
+	}
+	else {
+		ref["enabled"] = false;
+	}
+	pending_removes.push_back(ref["key"]);
+	SceneDB::QueueComponentChanges(this);
 }
 
 void Actor::OnTriggerEnter(Collision c) {
 	c.point = b2Vec2(-999.0f, -999.0f);
 	c.normal = b2Vec2(-999.0f, -999.0f);
-	for (std::shared_ptr<Component>& comp_ptr : OnTriggerQueue) {
-		Component* comp = comp_ptr.get();
-		luabridge::LuaRef* ref = comp->componentRef.get();
+	for (int slot : OnTriggerQueue) {
+		luabridge::LuaRef* ref = component_pool[slot].componentRef.get();
 		if ((*ref)["OnTriggerEnter"].isFunction()) {
 			(*ref)["OnTriggerEnter"](*ref, c);
 		}
@@ -530,9 +660,8 @@ void Actor::OnTriggerEnter(Collision c) {
 void Actor::OnTriggerExit(Collision c) {
 	c.point = b2Vec2(-999.0f, -999.0f);
 	c.normal = b2Vec2(-999.0f, -999.0f);
-	for (std::shared_ptr<Component>& comp_ptr : OnTriggerQueue) {
-		Component* comp = comp_ptr.get();
-		luabridge::LuaRef* ref = comp->componentRef.get();
+	for (int slot : OnTriggerQueue) {
+		luabridge::LuaRef* ref = component_pool[slot].componentRef.get();
 		if ((*ref)["OnTriggerExit"].isFunction()) {
 			(*ref)["OnTriggerExit"](*ref, c);
 		}
@@ -540,9 +669,8 @@ void Actor::OnTriggerExit(Collision c) {
 }
 
 void Actor::OnCollisionEnter(Collision c) {
-	for (std::shared_ptr<Component>& comp_ptr : OnCollisionQueue) {
-		Component* comp = comp_ptr.get();
-		luabridge::LuaRef* ref = comp->componentRef.get();
+	for (int slot : OnCollisionQueue) {
+		luabridge::LuaRef* ref = component_pool[slot].componentRef.get();
 		if ((*ref)["OnCollisionEnter"].isFunction()) {
 			(*ref)["OnCollisionEnter"](*ref, c);
 		}
@@ -552,9 +680,8 @@ void Actor::OnCollisionEnter(Collision c) {
 void Actor::OnCollisionExit(Collision c) {
 	c.point = b2Vec2(-999.0f, -999.0f);
 	c.normal = b2Vec2(-999.0f, -999.0f);
-	for (std::shared_ptr<Component>& comp_ptr : OnCollisionQueue) {
-		Component* comp = comp_ptr.get();
-		luabridge::LuaRef* ref = comp->componentRef.get();
+	for (int slot : OnCollisionQueue) {
+		luabridge::LuaRef* ref = component_pool[slot].componentRef.get();
 		if ((*ref)["OnCollisionExit"].isFunction()) {
 			(*ref)["OnCollisionExit"](*ref, c);
 		}
@@ -564,7 +691,7 @@ void Actor::OnCollisionExit(Collision c) {
 // ---------- [ LUA REFERENCE FUNCTIONS ] -----------
 
 void Actor::InjectConvenienceReferences(std::shared_ptr<luabridge::LuaRef> component_ref) {
-	(*component_ref)["actor"] = this;
+	(*component_ref)["actor"] = ActorPool::GetHandle(this);
 }
 
 uint32_t Actor::GetID() {
@@ -584,53 +711,63 @@ luabridge::LuaRef Actor::GetComponentByKey(std::string key) {
 		return luabridge::LuaRef(ComponentManager::lua_state);
 	}
 	else {
-		// TODO: check if we need to error check this or something bcuz it's a smart pointer
-		return *itr->second->componentRef;
+		return GetProxy(component_pool[itr->second]);
 	}
 }
 
 luabridge::LuaRef Actor::GetComponent(std::string type_name) {
-	std::string key = "";
-	for (const auto& component : components) {
-		const std::shared_ptr<Component>& comp_ptr = component.second;
-		// TODO: Check if removing isEnabled is necessary
-		if (comp_ptr->type == type_name && comp_ptr->isEnabled()) {
-			if (key == "" || comp_ptr->key < key) {
-				key = comp_ptr->key;
+	int type_id = ComponentDB::GetTypeID(type_name);
+	if (type_id >= 0 && type_id < static_cast<int>(components_by_type.size())) {
+		// Already in key order, the first enabled one wins
+		for (int slot : components_by_type[type_id]) {
+			Component& c = component_pool[slot];
+			if (c.isEnabled()) {
+				return GetProxy(c);
 			}
 		}
 	}
-	if (key == "") {
-		return luabridge::LuaRef(ComponentManager::lua_state);
-	}
-	else {
-		luabridge::LuaRef ref = *components[key]->componentRef;
-		return ref;
-	}
+	return luabridge::LuaRef(ComponentManager::lua_state);
 }
 
 luabridge::LuaRef Actor::GetComponents(std::string type_name) {
-	// Find all matches and sort them by key order
-	std::vector<std::shared_ptr<Component>> matches;
-	for (const auto& component : components) {
-		const std::shared_ptr<Component>& comp_ptr = component.second;
-		if (comp_ptr->type == type_name && comp_ptr->isEnabled()) {
-			matches.push_back(comp_ptr);
-		}
-	}
-	std::sort(matches.begin(), matches.end(), ComponentManager::CompareComponents);
-
-	// Make a table and insert all matches into it
 	lua_State* lua_state = ComponentManager::lua_state;
-
 	luabridge::LuaRef table = luabridge::newTable(lua_state);
 
-	// Add {i : LuaRef to Component} to table
-	for (uint32_t i = 0; i < matches.size(); i++) {
-		// Lua tables are 1-indexed
-		table[i + 1] = *matches[i]->componentRef;
+	int type_id = ComponentDB::GetTypeID(type_name);
+	if (type_id < 0 || type_id >= static_cast<int>(components_by_type.size())) {
+		return table;
 	}
 
+	// Add {i : LuaRef to Component} to table, the index is already in key order
+	int i = 1;
+	for (int slot : components_by_type[type_id]) {
+		Component& c = component_pool[slot];
+		if (c.isEnabled()) {
+			// Lua tables are 1-indexed
+			table[i++] = GetProxy(c);
+		}
+	}
 	return table;
 }
 
+bool Actor::HasComponent(std::string type_name) {
+	int type_id = ComponentDB::GetTypeID(type_name);
+	if (type_id < 0 || type_id / 64 >= static_cast<int>(component_mask.size())) {
+		return false;
+	}
+	return (component_mask[type_id / 64] >> (type_id % 64)) & 1;
+}
+
+bool Actor::HasTag(std::string tag) {
+	int bit = TagDB::GetTagBit(tag);
+	return bit >= 0 && ((tags >> bit) & 1);
+}
+
+void Actor::RefilterBodies() {
+	if (COMPONENT_TYPE_RIGIDBODY >= static_cast<int>(components_by_type.size())) {
+		return;
+	}
+	for (int slot : components_by_type[COMPONENT_TYPE_RIGIDBODY]) {
+		static_cast<Rigidbody*>(component_pool[slot].native)->Refilter();
+	}
+}
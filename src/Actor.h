@@ -6,29 +6,61 @@
 #include "ImageDB.h"
 #include <optional>
 #include <unordered_map>
+#include <deque>
 #include "Component.h"
 #include "Rigidbody.h"
 
 class Collision;
+struct TemplatePrototype;
 
 class Actor
 {
 public:
 	uint32_t id;
+
+	// Where ActorPool keeps this actor, handles to it carry both
+	uint32_t pool_slot = 0;
+	uint32_t pool_generation = 0;
+
 	std::string name = "";
 	std::string template_name = "";
-	std::unordered_map<std::string, std::shared_ptr<Component>> components;
+	// One bit per tag interned by TagDB, change it through TagDB::AddTags/RemoveTags
+	uint64_t tags = 0;
+
 	bool deleted = false;
 	bool dontdelete = false;
 
-	std::vector<std::shared_ptr<Component>> OnStartComponentQueue;
-	std::vector<std::shared_ptr<Component>> OnUpdateComponentQueue;
-	std::vector<std::shared_ptr<Component>> OnLateUpdateComponentQueue;
+	// Every component of the actor is stored once here, everything else refers to it by slot.
+	// A deque keeps addresses stable as it grows, freed slots are reused by later components.
+	std::deque<Component> component_pool;
+	std::vector<int> free_component_slots;
+
+	// Component key -> slot in component_pool, change it through InsertComponent/EraseComponent
+	std::unordered_map<std::string, int> components;
+
+	// Type ID -> slots of that type sorted by component key, kept in step with components
+	std::vector<std::vector<int>> components_by_type;
+
+	// Bit [type ID] is set while the actor holds a component of that type
+	std::vector<uint64_t> component_mask;
 
-	std::vector<std::shared_ptr<Component>> OnCollisionQueue;
-	std::vector<std::shared_ptr<Component>> OnTriggerQueue;
+	// Slots in component_pool, sorted by component key
+	std::vector<int> OnStartComponentQueue;
+	std::vector<int> OnUpdateComponentQueue;
+	std::vector<int> OnLateUpdateComponentQueue;
 
-	std::vector<std::shared_ptr<Component>> OnDeleteQueue;
+	std::vector<int> OnCollisionQueue;
+	std::vector<int> OnTriggerQueue;
+
+	std::vector<int> OnDeleteQueue;
+
+	// Component changes made this frame, applied in one pass by SceneDB::ProcessActorUpdates.
+	// They live on the actor, so they are dropped with it instead of being searched for.
+	std::vector<int> pending_adds; // slots in component_pool
+	std::vector<std::string> pending_removes; // component keys
+
+	// Set while the actor is in SceneDB::ActorsComponentChanged
+	bool component_changes_queued = false;
 
 	Actor();
 	//Actor(const Actor& other);
@@ -37,12 +69,38 @@ public:
 	// Create an actor and initialize components given a rapidjson::Value
 	void CreateActorFromValue(rapidjson::Value& arr);
 
-	// Add component to queues
-	void AddComponentToQueues(Component& c);
+	// Same as CreateActorFromValue with the template's json, copying what TemplateDB compiled from it
+	void CreateFromPrototype(const TemplatePrototype& prototype);
+
+	// Add the component in [slot] to queues
+	void AddComponentToQueues(int slot);
+
+	// Removes every one of [slots] from every queue, one pass per queue
+	void RemoveComponentsFromQueues(const std::vector<int>& slots);
+
+	// Clears every queue and queues each component again, as if the actor were just created
+	void ResetQueues();
+
+	// Copies a component into a free slot and returns the slot
+	int AddToPool(const Component& c);
+
+	// Clears [slot] for reuse, the component must already be out of components and the queues
+	void FreeSlot(int slot);
+
+	// Adds [slot] to components under [key] and to the type index, unless the key is taken
+	void InsertComponent(const std::string& key, int slot);
+
+	// Removes [key] from components and the type index
+	void EraseComponent(const std::string& key);
+
+	// Returns what scripts see of [c], a slot in component_pool. Native and data-only components
+	// get their proxy or table here the first time, most static actors never need one.
+	luabridge::LuaRef& GetProxy(Component& c);
 
 	// ---------[RUN FUNCTIONS]---------
 	void Start();
-	void Update();
+	// Runs every queued OnUpdate, or only native components' when Lua components are dispatched per type
+	void Update(bool include_lua = true);
 	void LateUpdate();
 
 	// ---------[LUA RUNTIME FUNCTIONS]-----------
@@ -63,7 +121,7 @@ public:
 
 
 	// ---------[LUA REFERENCE FUNCTIONS]----------
-	// Makes a raw pointer of the owning Actor available in Lua
+	// Makes a handle to the owning Actor available in Lua
 	void InjectConvenienceReferences(std::shared_ptr<luabridge::LuaRef> component_ref);
 
 	// Returns owning actor's ID
@@ -81,10 +139,29 @@ public:
 	// Creates an indexed table (or empty table) of components sorted by key
 	luabridge::LuaRef GetComponents(std::string type_name);
 
+	// Returns whether the actor holds a component of [type_name], enabled or not
+	bool HasComponent(std::string type_name);
+
+	// Returns whether the actor carries [tag]
+	bool HasTag(std::string tag);
+
+	// Has Box2D filter this actor's existing contacts again, call after its tags change
+	void RefilterBodies();
+
 private:
+	// Sorts a queue of slots by component key
+	void SortQueue(std::vector<int>& queue);
+
 	// Create a component helper function using rapidjson::Value of components object
 	void CreateComponents(const rapidjson::Value& comp_arr);
 
+	// Adds a native component that already holds its values under [key] and queues it
+	template <class T>
+	void AddNativeComponent(T* native, const std::string& type_name, const std::string& key);
+
+	// Adds the json values of a data-only component to its field list instead of a Lua table
+	void ReadDataOnlyFields(Component& c, const rapidjson::Value& value);
+
 	// Helper function to create a component, used only in CreateComponents
 	void CreateComponent(rapidjson::Value::ConstMemberIterator itr, std::string type, std::string name);
 
@@ -93,5 +170,8 @@ private:
 
 	// Helper function to create a ParticleSystem component, used only in Create Components
 	void CreateParticleSystem(rapidjson::Value::ConstMemberIterator itr, std::string name);
+
+	// Helper function to create a Tilemap component, used only in Create Components
+	void CreateTilemap(rapidjson::Value::ConstMemberIterator itr, std::string name);
 };
 
@@ -0,0 +1,158 @@
+#include "ActorPool.h"
+#include "Actor.h"
+#include "ComponentManager.h"
+#include "TagDB.h"
+
+// --- [ ACTOR HANDLE ] ---
+
+Actor* ActorHandle::Get() const {
+	return ActorPool::Resolve(slot, generation);
+}
+
+bool ActorHandle::IsValid() const {
+	return Get() != nullptr;
+}
+
+std::string ActorHandle::GetName() const {
+	Actor* a = Get();
+	return a == nullptr ? "" : a->GetName();
+}
+
+uint32_t ActorHandle::GetID() const {
+	Actor* a = Get();
+	return a == nullptr ? 0 : a->GetID();
+}
+
+luabridge::LuaRef ActorHandle::GetComponent(std::string type_name) const {
+	Actor* a = Get();
+	return a == nullptr ? luabridge::LuaRef(ComponentManager::lua_state) : a->GetComponent(type_name);
+}
+
+luabridge::LuaRef ActorHandle::GetComponentByKey(std::string key) const {
+	Actor* a = Get();
+	return a == nullptr ? luabridge::LuaRef(ComponentManager::lua_state) : a->GetComponentByKey(key);
+}
+
+luabridge::LuaRef ActorHandle::GetComponents(std::string type_name) const {
+	Actor* a = Get();
+	return a == nullptr ? luabridge::newTable(ComponentManager::lua_state) : a->GetComponents(type_name);
+}
+
+bool ActorHandle::HasComponent(std::string type_name) const {
+	Actor* a = Get();
+	return a != nullptr && a->HasComponent(type_name);
+}
+
+bool ActorHandle::HasTag(std::string tag) const {
+	Actor* a = Get();
+	return a != nullptr && a->HasTag(tag);
+}
+
+void ActorHandle::AddTag(luabridge::LuaRef tags) const {
+	Actor* a = Get();
+	if (a != nullptr) {
+		TagDB::AddTags(a, TagDB::MaskFromLua(tags));
+		a->RefilterBodies();
+	}
+}
+
+void ActorHandle::RemoveTag(luabridge::LuaRef tags) const {
+	Actor* a = Get();
+	if (a != nullptr) {
+		TagDB::RemoveTags(a, TagDB::MaskFromLua(tags, false));
+		a->RefilterBodies();
+	}
+}
+
+luabridge::LuaRef ActorHandle::AddComponent(std::string type_name) const {
+	Actor* a = Get();
+	return a == nullptr ? luabridge::LuaRef(ComponentManager::lua_state) : a->AddComponent(type_name);
+}
+
+void ActorHandle::RemoveComponent(luabridge::LuaRef ref) const {
+	Actor* a = Get();
+	if (a != nullptr) {
+		a->RemoveComponent(ref);
+	}
+}
+
+bool ActorHandle::Equals(const ActorHandle& other) const {
+	return slot == other.slot && generation == other.generation;
+}
+
+// --- [ ACTOR POOL ] ---
+
+Actor* ActorPool::Allocate(uint32_t id) {
+	uint32_t slot;
+	if (!free_slots.empty()) {
+		slot = free_slots.back();
+		free_slots.pop_back();
+	}
+	else {
+		slot = static_cast<uint32_t>(generations.size());
+		if (slot % chunk_size == 0) {
+			chunks.push_back(std::unique_ptr<Actor[]>(new Actor[chunk_size]));
+		}
+		generations.push_back(1);
+		live.push_back(false);
+	}
+	live[slot] = true;
+
+	Actor& a = At(slot);
+	a.id = id;
+	a.pool_slot = slot;
+	a.pool_generation = generations[slot];
+	id_to_slot[id] = slot;
+	return &a;
+}
+
+void ActorPool::Release(Actor* a) {
+	uint32_t slot = a->pool_slot;
+	id_to_slot.erase(a->id);
+	// Drops the components (and their Lua references) now rather than when the slot is reused
+	*a = Actor();
+	generations[slot]++;
+	live[slot] = false;
+	free_slots.push_back(slot);
+}
+
+void ActorPool::Retire(Actor* a) {
+	uint32_t slot = a->pool_slot;
+	id_to_slot.erase(a->id);
+	generations[slot]++;
+	live[slot] = false;
+}
+
+void ActorPool::Revive(Actor* a, uint32_t id) {
+	uint32_t slot = a->pool_slot;
+	live[slot] = true;
+	a->id = id;
+	a->pool_generation = generations[slot];
+	id_to_slot[id] = slot;
+}
+
+ActorHandle ActorPool::GetHandle(const Actor* a) {
+	if (a == nullptr) {
+		return ActorHandle();
+	}
+	return { a->pool_slot, a->pool_generation };
+}
+
+Actor* ActorPool::Resolve(uint32_t slot, uint32_t generation) {
+	if (slot >= generations.size() || !live[slot] || generations[slot] != generation) {
+		return nullptr;
+	}
+	return &At(slot);
+}
+
+Actor* ActorPool::FindByID(uint32_t id) {
+	auto itr = id_to_slot.find(id);
+	if (itr == id_to_slot.end()) {
+		return nullptr;
+	}
+	return &At(itr->second);
+}
+
+Actor& ActorPool::At(uint32_t slot) {
+	return chunks[slot / chunk_size][slot % chunk_size];
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "lua.hpp"
+#include "LuaBridge/LuaBridge.h"
+
+class Actor;
+
+// What Lua holds instead of an Actor*. A handle names a pool slot and the generation of the actor
+// living in it, so once that actor is released every old handle resolves to nothing.
+struct ActorHandle {
+	uint32_t slot = 0;
+	uint32_t generation = 0; // generations start at 1, so a default handle is never valid
+
+	// Returns the actor, or nullptr if it has been released
+	Actor* Get() const;
+
+	// --- [ LUA FUNCTIONS ] ---
+
+	// Returns whether the actor still exists
+	bool IsValid() const;
+
+	// Stale handles return "" and 0
+	std::string GetName() const;
+	uint32_t GetID() const;
+
+	// Stale handles return nil (or an empty table) and ignore changes
+	luabridge::LuaRef GetComponent(std::string type_name) const;
+	luabridge::LuaRef GetComponentByKey(std::string key) const;
+	luabridge::LuaRef GetComponents(std::string type_name) const;
+	bool HasComponent(std::string type_name) const;
+	bool HasTag(std::string tag) const;
+
+	// Takes a tag name or a table of tag names
+	void AddTag(luabridge::LuaRef tags) const;
+	void RemoveTag(luabridge::LuaRef tags) const;
+	luabridge::LuaRef AddComponent(std::string type_name) const;
+	void RemoveComponent(luabridge::LuaRef ref) const;
+
+	// __eq, two handles are equal when they name the same actor
+	bool Equals(const ActorHandle& other) const;
+};
+
+// Owns every actor. Actors live in fixed size chunks, so they stay at the same address for their whole
+// life and neighbours in the pool are neighbours in memory. Released slots are reused by later actors.
+class ActorPool
+{
+public:
+	inline static const uint32_t chunk_size = 256;
+
+	// Returns a fresh actor with [id], reusing a released slot if there is one
+	static Actor* Allocate(uint32_t id);
+
+	// Resets the actor and bumps its slot's generation, invalidating every handle to it
+	static void Release(Actor* a);
+
+	// Invalidates every handle to the actor like Release, but keeps it and its slot as they are so a
+	// TemplatePool can reuse it
+	static void Retire(Actor* a);
+
+	// Makes a retired actor live again under [id] with a new generation
+	static void Revive(Actor* a, uint32_t id);
+
+	// Returns the handle of [a], or an invalid handle for nullptr
+	static ActorHandle GetHandle(const Actor* a);
+
+	// Returns the live actor in [slot] if its generation matches, otherwise nullptr
+	static Actor* Resolve(uint32_t slot, uint32_t generation);
+
+	// Returns the live actor with [id], or nullptr
+	static Actor* FindByID(uint32_t id);
+
+	// Getter for the "actor" property of native components
+	template <class T>
+	static ActorHandle GetOwner(const T* component) {
+		return GetHandle(component->actor);
+	}
+
+private:
+	inline static std::vector<std::unique_ptr<Actor[]>> chunks;
+
+	// Per slot, the generation of the actor in it and whether the slot is in use
+	inline static std::vector<uint32_t> generations;
+	inline static std::vector<bool> live;
+
+	inline static std::vector<uint32_t> free_slots;
+
+	inline static std::unordered_map<uint32_t, uint32_t> id_to_slot;
+
+	static Actor& At(uint32_t slot);
+};
@@ -0,0 +1,314 @@
+#include "Canvas.h"
+#include "Renderer.h"
+#include "Helper.h"
+#include "RenderStats.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CANVAS_SSE2 1
+#endif
+
+// --- [ FRAME ] ---
+
+void Canvas::Flush() {
+	RenderStats::RecordSubmitted(requests);
+	requests = 0;
+	if (!has_content || texture == nullptr) {
+		return;
+	}
+
+	// Upload only the rows that changed since the last frame
+	if (dirty_min_y <= dirty_max_y) {
+		SDL_Rect rows = { 0, dirty_min_y, width, dirty_max_y - dirty_min_y + 1 };
+		const uint32_t* src = pixels.data() + static_cast<size_t>(dirty_min_y) * width;
+		if (premultiplied_supported) {
+			SDL_UpdateTexture(texture, &rows, src, width * sizeof(uint32_t));
+		}
+		else {
+			// Un-premultiply for plain alpha blending
+			size_t count = static_cast<size_t>(rows.h) * width;
+			upload_scratch.resize(count);
+			for (size_t i = 0; i < count; i++) {
+				uint32_t p = src[i];
+				uint32_t a = p >> 24;
+				if (a == 0 || a == 255) {
+					upload_scratch[i] = p;
+					continue;
+				}
+				uint32_t r = std::min(255u, ((p >> 16) & 0xFF) * 255 / a);
+				uint32_t g = std::min(255u, ((p >> 8) & 0xFF) * 255 / a);
+				uint32_t b = std::min(255u, (p & 0xFF) * 255 / a);
+				upload_scratch[i] = (a << 24) | (r << 16) | (g << 8) | b;
+			}
+			SDL_UpdateTexture(texture, &rows, upload_scratch.data(), width * sizeof(uint32_t));
+		}
+	}
+
+	Helper::SDL_RenderCopy(Renderer::renderer, texture, nullptr, nullptr);
+	RenderStats::RecordDraw(texture, { 255, 255, 255, 255 });
+
+	dirty_min_y = height;
+	dirty_max_y = -1;
+	if (!persistent) {
+		// Pixels only last a frame, so wipe the rows drawn this frame and upload them cleared next time
+		if (drawn_min_y <= drawn_max_y) {
+			std::memset(pixels.data() + static_cast<size_t>(drawn_min_y) * width, 0, static_cast<size_t>(drawn_max_y - drawn_min_y + 1) * width * sizeof(uint32_t));
+			dirty_min_y = drawn_min_y;
+			dirty_max_y = drawn_max_y;
+		}
+		has_content = false;
+	}
+	drawn_min_y = height;
+	drawn_max_y = -1;
+}
+
+// --- [ LUA CANVAS FUNCTIONS ] ---
+
+void Canvas::SetPixel(float x, float y, float r, float g, float b, float a) {
+	EnsureCreated();
+	requests++;
+	int px = static_cast<int>(x);
+	int py = static_cast<int>(y);
+	if (px < 0 || py < 0 || px >= width || py >= height) {
+		return;
+	}
+	pixels[static_cast<size_t>(py) * width + px] = Premultiply(static_cast<int>(r), static_cast<int>(g), static_cast<int>(b), static_cast<int>(a));
+	MarkDirty(py, py);
+}
+
+void Canvas::BlendPixel(float x, float y, float r, float g, float b, float a) {
+	EnsureCreated();
+	requests++;
+	int px = static_cast<int>(x);
+	int py = static_cast<int>(y);
+	if (px < 0 || py < 0 || px >= width || py >= height) {
+		return;
+	}
+	BlendSpan(&pixels[static_cast<size_t>(py) * width + px], 1, Premultiply(static_cast<int>(r), static_cast<int>(g), static_cast<int>(b), static_cast<int>(a)));
+	MarkDirty(py, py);
+}
+
+void Canvas::Fill(float x, float y, float w, float h, float r, float g, float b, float a) {
+	EnsureCreated();
+	requests++;
+	int x0 = std::max(0, static_cast<int>(x));
+	int y0 = std::max(0, static_cast<int>(y));
+	int x1 = std::min(width, static_cast<int>(x + w));
+	int y1 = std::min(height, static_cast<int>(y + h));
+	if (x0 >= x1 || y0 >= y1) {
+		return;
+	}
+	int alpha = std::clamp(static_cast<int>(a), 0, 255);
+	uint32_t color = Premultiply(static_cast<int>(r), static_cast<int>(g), static_cast<int>(b), alpha);
+	for (int row = y0; row < y1; row++) {
+		uint32_t* dst = &pixels[static_cast<size_t>(row) * width + x0];
+		if (alpha == 255) {
+			FillSpan(dst, x1 - x0, color);
+		}
+		else {
+			BlendSpan(dst, x1 - x0, color);
+		}
+	}
+	MarkDirty(y0, y1 - 1);
+}
+
+void Canvas::DrawLine(float x0, float y0, float x1, float y1, float r, float g, float b, float a) {
+	EnsureCreated();
+	requests++;
+	uint32_t color = Premultiply(static_cast<int>(r), static_cast<int>(g), static_cast<int>(b), static_cast<int>(a));
+	int cx = static_cast<int>(x0);
+	int cy = static_cast<int>(y0);
+	int ex = static_cast<int>(x1);
+	int ey = static_cast<int>(y1);
+
+	// Horizontal lines are a single span
+	if (cy == ey) {
+		if (cy < 0 || cy >= height) {
+			return;
+		}
+		int from = std::max(0, std::min(cx, ex));
+		int to = std::min(width - 1, std::max(cx, ex));
+		if (from <= to) {
+			BlendSpan(&pixels[static_cast<size_t>(cy) * width + from], to - from + 1, color);
+			MarkDirty(cy, cy);
+		}
+		return;
+	}
+
+	// Bresenham
+	int dx = std::abs(ex - cx);
+	int dy = -std::abs(ey - cy);
+	int sx = cx < ex ? 1 : -1;
+	int sy = cy < ey ? 1 : -1;
+	int err = dx + dy;
+	while (true) {
+		if (cx >= 0 && cy >= 0 && cx < width && cy < height) {
+			BlendSpan(&pixels[static_cast<size_t>(cy) * width + cx], 1, color);
+		}
+		if (cx == ex && cy == ey) {
+			break;
+		}
+		int e2 = 2 * err;
+		if (e2 >= dy) {
+			err += dy;
+			cx += sx;
+		}
+		if (e2 <= dx) {
+			err += dx;
+			cy += sy;
+		}
+	}
+	MarkDirty(std::min(static_cast<int>(y0), ey), std::max(static_cast<int>(y0), ey));
+}
+
+void Canvas::Blit(float x, float y, float w, float h, luabridge::LuaRef pixel_table) {
+	EnsureCreated();
+	requests++;
+	if (!pixel_table.isTable()) {
+		return;
+	}
+	int px = static_cast<int>(x);
+	int py = static_cast<int>(y);
+	int bw = static_cast<int>(w);
+	int bh = static_cast<int>(h);
+
+	lua_State* L = pixel_table.state();
+	pixel_table.push(L);
+	int table_index = lua_gettop(L);
+	for (int row = 0; row < bh; row++) {
+		int dst_y = py + row;
+		if (dst_y < 0 || dst_y >= height) {
+			continue;
+		}
+		uint32_t* dst_row = &pixels[static_cast<size_t>(dst_y) * width];
+		for (int col = 0; col < bw; col++) {
+			int dst_x = px + col;
+			if (dst_x < 0 || dst_x >= width) {
+				continue;
+			}
+			// Lua arrays are 1-indexed
+			lua_rawgeti(L, table_index, static_cast<lua_Integer>(row) * bw + col + 1);
+			uint32_t rgba = static_cast<uint32_t>(lua_tointeger(L, -1));
+			lua_pop(L, 1);
+			dst_row[dst_x] = Premultiply((rgba >> 24) & 0xFF, (rgba >> 16) & 0xFF, (rgba >> 8) & 0xFF, rgba & 0xFF);
+		}
+	}
+	lua_pop(L, 1);
+	MarkDirty(py, py + bh - 1);
+}
+
+void Canvas::Clear() {
+	if (pixels.empty()) {
+		return;
+	}
+	std::memset(pixels.data(), 0, pixels.size() * sizeof(uint32_t));
+	MarkDirty(0, height - 1);
+	has_content = false;
+}
+
+void Canvas::SetPersistent(bool persistent_in) {
+	persistent = persistent_in;
+}
+
+// --- [ HELPER FUNCTIONS ] ---
+
+void Canvas::EnsureCreated() {
+	if (texture != nullptr) {
+		return;
+	}
+	width = static_cast<int>(Renderer::window_size.x);
+	height = static_cast<int>(Renderer::window_size.y);
+	pixels.assign(static_cast<size_t>(width) * height, 0);
+
+	texture = SDL_CreateTexture(Renderer::renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+	SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(
+		SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+		SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+	if (SDL_SetTextureBlendMode(texture, premultiplied) != 0) {
+		premultiplied_supported = false;
+		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	}
+
+	// The texture starts with undefined contents
+	dirty_min_y = 0;
+	dirty_max_y = height - 1;
+	drawn_min_y = height;
+	drawn_max_y = -1;
+}
+
+void Canvas::MarkDirty(int min_y, int max_y) {
+	min_y = std::max(0, min_y);
+	max_y = std::min(height - 1, max_y);
+	if (min_y > max_y) {
+		return;
+	}
+	dirty_min_y = std::min(dirty_min_y, min_y);
+	dirty_max_y = std::max(dirty_max_y, max_y);
+	drawn_min_y = std::min(drawn_min_y, min_y);
+	drawn_max_y = std::max(drawn_max_y, max_y);
+	has_content = true;
+}
+
+uint32_t Canvas::Premultiply(int r, int g, int b, int a) {
+	uint32_t alpha = static_cast<uint32_t>(std::clamp(a, 0, 255));
+	uint32_t pr = (static_cast<uint32_t>(std::clamp(r, 0, 255)) * alpha + 127) / 255;
+	uint32_t pg = (static_cast<uint32_t>(std::clamp(g, 0, 255)) * alpha + 127) / 255;
+	uint32_t pb = (static_cast<uint32_t>(std::clamp(b, 0, 255)) * alpha + 127) / 255;
+	return (alpha << 24) | (pr << 16) | (pg << 8) | pb;
+}
+
+void Canvas::FillSpan(uint32_t* dst, int count, uint32_t color) {
+	int i = 0;
+#ifdef CANVAS_SSE2
+	__m128i fill = _mm_set1_epi32(static_cast<int>(color));
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), fill);
+	}
+#endif
+	for (; i < count; i++) {
+		dst[i] = color;
+	}
+}
+
+void Canvas::BlendSpan(uint32_t* dst, int count, uint32_t color) {
+	uint32_t inv_alpha = 255 - (color >> 24);
+	if (inv_alpha == 255) {
+		return; // fully transparent source
+	}
+	if (inv_alpha == 0) {
+		FillSpan(dst, count, color);
+		return;
+	}
+	// out = src + dst * (255 - src_a) / 255, per channel
+	int i = 0;
+#ifdef CANVAS_SSE2
+	__m128i zero = _mm_setzero_si128();
+	__m128i src = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(color)), zero);
+	__m128i inv = _mm_set1_epi16(static_cast<short>(inv_alpha));
+	__m128i round = _mm_set1_epi16(128);
+	for (; i + 4 <= count; i += 4) {
+		__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+		__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv), round);
+		__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv), round);
+		// Exact division by 255: (t + (t >> 8)) >> 8
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+		lo = _mm_add_epi16(lo, src);
+		hi = _mm_add_epi16(hi, src);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+	}
+#endif
+	for (; i < count; i++) {
+		uint32_t d = dst[i];
+		uint32_t out = 0;
+		for (int shift = 0; shift < 32; shift += 8) {
+			uint32_t t = ((d >> shift) & 0xFF) * inv_alpha + 128;
+			uint32_t channel = ((t + (t >> 8)) >> 8) + ((color >> shift) & 0xFF);
+			out |= std::min(channel, 255u) << shift;
+		}
+		dst[i] = out;
+	}
+}
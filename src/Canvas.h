@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "SDL2/SDL.h"
+#include "lua.hpp"
+#include "LuaBridge/LuaBridge.h"
+
+// A window sized CPU pixel buffer that is uploaded through one streaming texture per frame.
+// Pixels are stored as premultiplied ARGB8888 so blending is a multiply-add per channel.
+class Canvas
+{
+public:
+	// Uploads the rows drawn this frame and composites the canvas over the screen
+	static void Flush();
+
+	// --- [ LUA CANVAS FUNCTIONS ] ---
+
+	// Overwrites a single pixel
+	static void SetPixel(float x, float y, float r, float g, float b, float a);
+
+	// Alpha blends a single pixel over the canvas (used by Image.DrawPixel)
+	static void BlendPixel(float x, float y, float r, float g, float b, float a);
+
+	// Alpha blends a filled rectangle over the canvas
+	static void Fill(float x, float y, float w, float h, float r, float g, float b, float a);
+
+	// Alpha blends a one pixel wide line over the canvas
+	static void DrawLine(float x0, float y0, float x1, float y1, float r, float g, float b, float a);
+
+	// Copies a w x h block of packed 0xRRGGBBAA integers (a Lua array, row by row) onto the canvas
+	static void Blit(float x, float y, float w, float h, luabridge::LuaRef pixel_table);
+
+	// Clears the whole canvas to transparent
+	static void Clear();
+
+	// A persistent canvas keeps its contents between frames instead of being cleared after each flush
+	static void SetPersistent(bool persistent);
+
+private:
+	inline static std::vector<uint32_t> pixels;
+	inline static int width = 0;
+	inline static int height = 0;
+
+	inline static SDL_Texture* texture = nullptr;
+
+	// False when the renderer cannot composite premultiplied alpha, in which case rows are converted on upload
+	inline static bool premultiplied_supported = true;
+	inline static std::vector<uint32_t> upload_scratch;
+
+	// Rows that differ from the texture, dirty_min_y > dirty_max_y when nothing changed
+	inline static int dirty_min_y = 0;
+	inline static int dirty_max_y = -1;
+
+	// Rows drawn since the last flush, wiped after the flush unless the canvas is persistent
+	inline static int drawn_min_y = 0;
+	inline static int drawn_max_y = -1;
+
+	// Whether anything is on the canvas and it needs to be composited
+	inline static bool has_content = false;
+
+	inline static bool persistent = false;
+
+	// Draw calls made since the last flush, reported to RenderStats
+	inline static int requests = 0;
+
+	// --- [ HELPER FUNCTIONS ] ---
+
+	// Sizes the buffer to the window and creates the streaming texture
+	static void EnsureCreated();
+
+	// Clamps a row range into the canvas and widens the dirty range
+	static void MarkDirty(int min_y, int max_y);
+
+	// Converts 0-255 channels into a premultiplied ARGB8888 pixel
+	static uint32_t Premultiply(int r, int g, int b, int a);
+
+	// Writes [count] copies of [color] starting at dst
+	static void FillSpan(uint32_t* dst, int count, uint32_t color);
+
+	// Blends premultiplied [color] over [count] pixels starting at dst
+	static void BlendSpan(uint32_t* dst, int count, uint32_t color);
+};
@@ -1,13 +1,41 @@
 #include "Component.h"
+#include "ComponentManager.h"
+#include "ComponentDB.h"
+#include "LuaDispatch.h"
 
 Component::Component() {
 	type = "";
 }
 
-Component::Component(std::string type) {
-	type = type;
+Component::Component(std::string type) : type(type) {
 }
 
-bool Component::isEnabled() {
-	return (*componentRef)["enabled"];
-}
\ No newline at end of file
+Component::~Component() {
+	ComponentDB::UntrackInstance(this);
+}
+
+bool Component::isEnabled() const {
+	return native_enabled != nullptr ? *native_enabled : enabled;
+}
+
+void Component::SetEnabled(bool value) {
+	if (native_enabled != nullptr) {
+		*native_enabled = value;
+		return;
+	}
+	if (componentRef) {
+		(*componentRef)["enabled"] = value;
+	}
+	if (enabled == value) {
+		return;
+	}
+	enabled = value;
+	LuaDispatch::OnEnabledChanged(this);
+}
+
+LifecycleRefs::~LifecycleRefs() {
+	lua_State* lua_state = ComponentManager::lua_state;
+	luaL_unref(lua_state, LUA_REGISTRYINDEX, on_start);
+	luaL_unref(lua_state, LUA_REGISTRYINDEX, on_update);
+	luaL_unref(lua_state, LUA_REGISTRYINDEX, on_late_update);
+}
@@ -1,24 +1,71 @@
 #pragma once
 #include <memory>
+#include <string>
+#include <variant>
+#include <vector>
 #include "lua.hpp"
 #include "LuaBridge/LuaBridge.h"
 
+struct ComponentPrototype;
+
+// A json value of a data-only component, kept in C++ until a script asks for the component's table
+struct ComponentField {
+	std::string name;
+	std::variant<bool, int, float, std::string> value;
+};
+
+// Registry references to a component's lifecycle functions, resolved once when the component is queued.
+// Shared between every copy of a Component and released with the last one.
+struct LifecycleRefs {
+	int on_start = LUA_NOREF;
+	int on_update = LUA_NOREF;
+	int on_late_update = LUA_NOREF;
+
+	~LifecycleRefs();
+};
+
 class Component
 {
 public:
 	Component();
 	explicit Component(std::string type);
+	~Component();
+
+	// Reads the native flag, Lua components mirror it into their "enabled" field
+	bool isEnabled() const;
 
-	// Checks componentRef table for "enabled" boolean
-	bool isEnabled();
+	// Sets the flag and its Lua mirror, and adds or removes the component from dispatch lists
+	void SetEnabled(bool value);
 
 	std::string key;
+	// Unset until a script asks for a native or data-only component, see Actor::GetProxy
 	std::shared_ptr<luabridge::LuaRef> componentRef;
 	std::string type;
 
-	bool hasStart;
-	bool hasUpdate;
-	bool hasLateUpdate;
-	bool hasDestroy;
+	// Interned ID of type, see ComponentDB::GetTypeID
+	int type_id = -1;
+
+	// Only set for Lua components, native components are dispatched directly
+	std::shared_ptr<LifecycleRefs> lifecycle;
+
+	// Lua components keep their flag here, native components point at their own enabled member
+	bool enabled = true;
+	bool* native_enabled = nullptr;
+
+	// The Rigidbody, ParticleSystem or Tilemap of a native component, C++ uses it instead of the proxy
+	void* native = nullptr;
+
+	// Template fields a data-only Lua component copies into its table once a script asks for it,
+	// followed by the scene's own [fields] (either may be unset)
+	const ComponentPrototype* prototype = nullptr;
+	std::shared_ptr<std::vector<ComponentField>> fields;
+
+	// Address of the Lua instance table once tracked by ComponentDB::TrackInstance
+	const void* instance = nullptr;
+
+	bool hasStart = false;
+	bool hasUpdate = false;
+	bool hasLateUpdate = false;
+	bool hasDestroy = false;
 };
 
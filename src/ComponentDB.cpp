@@ -2,6 +2,7 @@
 #include "ComponentManager.h"
 #include "EngineUtils.h"
 #include <memory>
+#include <algorithm>
 
 
 bool ComponentDB::CheckComponentExists(std::string componentName) {
@@ -14,20 +15,54 @@ bool ComponentDB::CheckComponentExists(std::string componentName) {
 // Reads all .lua files in resources/component_types for components and stores them in map with type as key.
 void ComponentDB::Initialize(lua_State* lua_state) {
 	lua_state = lua_state;
+
+	// Native types always keep the same IDs
+	InternType("Rigidbody");
+	InternType("ParticleSystem");
+	InternType("Tilemap");
+
 	const std::string component_dir_path = "resources/component_types/";
 	if (EngineUtils::CheckPathExists(component_dir_path)) {
+		// Sorted so the IDs of Lua types follow their names and do not depend on the file system
+		std::vector<std::filesystem::path> component_paths;
 		for (const auto& component : std::filesystem::directory_iterator(component_dir_path)) {
-			std::string name = component.path().filename().stem().string();
-			std::string extension = component.path().filename().extension().string();
+			component_paths.push_back(component.path());
+		}
+		std::sort(component_paths.begin(), component_paths.end());
+
+		for (const auto& component_path : component_paths) {
+			std::string name = component_path.filename().stem().string();
+			std::string extension = component_path.filename().extension().string();
 
 			// attempt to make the component table
-			if (luaL_dofile(lua_state, component.path().string().c_str()) != LUA_OK) {
+			if (luaL_dofile(lua_state, component_path.string().c_str()) != LUA_OK) {
 				std::cout << "problem with lua file " << name;
 				exit(0);
 			}
 			Component c = Component(name);
+			c.type_id = InternType(name);
 			// link component to LuaRef
 			c.componentRef = std::make_shared<luabridge::LuaRef>(luabridge::getGlobal(lua_state, name.c_str()));
+			// Instances inherit SetEnabled through their metatable
+			c.componentRef->push(lua_state);
+			lua_pushcfunction(lua_state, LuaSetEnabled);
+			lua_setfield(lua_state, -2, "SetEnabled");
+			lua_pop(lua_state, 1);
+
+			// Built once per type instead of once per instance
+			luabridge::LuaRef metatable = luabridge::newTable(lua_state);
+			metatable["__index"] = *c.componentRef;
+			metatables.resize(GetTypeCount());
+			live_tables.resize(GetTypeCount());
+			metatables[c.type_id] = std::make_shared<luabridge::LuaRef>(metatable);
+
+			data_only.resize(GetTypeCount());
+			data_only[c.type_id] = true;
+			for (const char* function_name : { "OnStart", "OnUpdate", "OnLateUpdate", "OnDestroy", "OnReset", "OnCollisionEnter", "OnCollisionExit", "OnTriggerEnter", "OnTriggerExit" }) {
+				if ((*c.componentRef)[function_name].isFunction()) {
+					data_only[c.type_id] = false;
+				}
+			}
 			// todo: check if this is worth moving instead of copying via make_pair
 			globalComponents.insert(std::make_pair(name, c));
 
@@ -41,11 +76,98 @@ void ComponentDB::EstablishInheritance(Component& instance, Component& parent) {
 		std::cout << "Error: parent.componentRef is null" << std::endl;
 		exit(0);
 	}
-	luabridge::LuaRef new_metatable = luabridge::newTable(ComponentManager::lua_state);
-	new_metatable["__index"] = *parent.componentRef;
-
 	instance.componentRef.get()->push(ComponentManager::lua_state);
-	new_metatable.push(ComponentManager::lua_state);
-	lua_setmetatable(ComponentManager::lua_state, -2);
+	SetInstanceMetatable(ComponentManager::lua_state, parent.type_id);
 	lua_pop(ComponentManager::lua_state, 1);
-}
\ No newline at end of file
+}
+
+void ComponentDB::SetInstanceMetatable(lua_State* L, int type_id) {
+	metatables[type_id]->push(L);
+	lua_setmetatable(L, -2);
+}
+
+luabridge::LuaRef ComponentDB::GetComponentTableCounts() {
+	luabridge::LuaRef table = luabridge::newTable(ComponentManager::lua_state);
+	for (int type_id = 0; type_id < static_cast<int>(live_tables.size()); type_id++) {
+		if (metatables[type_id]) {
+			table[type_names[type_id]] = live_tables[type_id];
+		}
+	}
+	return table;
+}
+
+
+int ComponentDB::GetTypeID(const std::string& type_name) {
+	auto itr = type_ids.find(type_name);
+	if (itr == type_ids.end()) {
+		return -1;
+	}
+	return itr->second;
+}
+
+int ComponentDB::GetTypeCount() {
+	return static_cast<int>(type_names.size());
+}
+
+bool ComponentDB::IsDataOnly(int type_id) {
+	return type_id >= 0 && type_id < static_cast<int>(data_only.size()) && data_only[type_id];
+}
+
+int ComponentDB::InternType(const std::string& type_name) {
+	auto itr = type_ids.find(type_name);
+	if (itr != type_ids.end()) {
+		return itr->second;
+	}
+	int id = static_cast<int>(type_names.size());
+	type_ids.emplace(type_name, id);
+	type_names.push_back(type_name);
+	return id;
+}
+
+void ComponentDB::TrackInstance(Component& c) {
+	lua_State* lua_state = ComponentManager::lua_state;
+	c.componentRef->push(lua_state);
+	c.instance = lua_topointer(lua_state, -1);
+	lua_pop(lua_state, 1);
+	if (instances.insert_or_assign(c.instance, &c).second && c.type_id >= 0 && c.type_id < static_cast<int>(live_tables.size())) {
+		live_tables[c.type_id]++;
+	}
+}
+
+void ComponentDB::UntrackInstance(Component* c) {
+	if (c->instance == nullptr) {
+		return;
+	}
+	// Copies carry the same address, only the tracked Component removes it
+	auto itr = instances.find(c->instance);
+	if (itr != instances.end() && itr->second == c) {
+		instances.erase(itr);
+		if (c->type_id >= 0 && c->type_id < static_cast<int>(live_tables.size())) {
+			live_tables[c->type_id]--;
+		}
+	}
+}
+
+Component* ComponentDB::FindInstance(luabridge::LuaRef& ref) {
+	lua_State* lua_state = ComponentManager::lua_state;
+	ref.push(lua_state);
+	const void* instance = lua_topointer(lua_state, -1);
+	lua_pop(lua_state, 1);
+	auto itr = instances.find(instance);
+	return itr == instances.end() ? nullptr : itr->second;
+}
+
+int ComponentDB::LuaSetEnabled(lua_State* L) {
+	luaL_checktype(L, 1, LUA_TTABLE);
+	bool value = lua_toboolean(L, 2);
+	auto itr = instances.find(lua_topointer(L, 1));
+	if (itr != instances.end()) {
+		itr->second->SetEnabled(value);
+	}
+	else {
+		// Not part of an actor yet (or anymore), only the field matters
+		lua_pushboolean(L, value);
+		lua_setfield(L, 1, "enabled");
+	}
+	return 0;
+}
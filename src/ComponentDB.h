@@ -1,17 +1,76 @@
 #pragma once
 #include <unordered_map>
 #include <string>
+#include <vector>
 #include "Component.h"
+
+// Fixed type IDs of the native components, Lua component types are numbered after them
+enum NativeComponentType {
+	COMPONENT_TYPE_RIGIDBODY = 0,
+	COMPONENT_TYPE_PARTICLE_SYSTEM = 1,
+	COMPONENT_TYPE_TILEMAP = 2,
+	NATIVE_COMPONENT_TYPE_COUNT
+};
+
 class ComponentDB
 {
 public:
 	inline static std::unordered_map<std::string, Component> globalComponents;
 
+	// Dense IDs of every component type, Lua types are numbered in name order
+	inline static std::unordered_map<std::string, int> type_ids;
+	inline static std::vector<std::string> type_names;
+
+	// Lua instance tables of live components, keyed by table address
+	inline static std::unordered_map<const void*, Component*> instances;
+
+	// The {__index = type table} metatable every instance of a Lua type shares, indexed by type ID
+	inline static std::vector<std::shared_ptr<luabridge::LuaRef>> metatables;
+
+	// Types without lifecycle or callback functions, indexed by type ID. Their template components
+	// get no table until a script asks for one.
+	inline static std::vector<bool> data_only;
+
+	// Instance tables per type ID held by components, counted by TrackInstance and UntrackInstance
+	inline static std::vector<int> live_tables;
+
 	static void Initialize(lua_State* lua_state);
 
 	// Checks if a component exists in the globalComponents map.
 	static bool CheckComponentExists(std::string componentName);
 
 	static void EstablishInheritance(Component& instance, Component& parent);
+
+	// Gives the table on top of the stack the shared metatable of [type_id]
+	static void SetInstanceMetatable(lua_State* L, int type_id);
+
+	// Lua: Debug.GetComponentTableCounts(), returns { type name = live instance tables }
+	static luabridge::LuaRef GetComponentTableCounts();
+
+	// Returns the ID of a component type, or -1 if there is no such type
+	static int GetTypeID(const std::string& type_name);
+
+	// Returns the number of interned component types
+	static int GetTypeCount();
+
+	// Returns whether [type_id] is a Lua type that defines none of the functions the engine calls
+	static bool IsDataOnly(int type_id);
+
+	// Lets component:SetEnabled find the Component of a Lua instance table
+	static void TrackInstance(Component& c);
+
+	// Forgets the instance table of [c] if [c] is the tracked Component
+	static void UntrackInstance(Component* c);
+
+	// Returns the tracked Component of a Lua instance, or nullptr
+	static Component* FindInstance(luabridge::LuaRef& ref);
+
+	// Lua: component:SetEnabled(enabled), installed on every Lua component type
+	static int LuaSetEnabled(lua_State* L);
+
+private:
+	// Assigns the next ID to a type name
+	static int InternType(const std::string& type_name);
+
 };
 
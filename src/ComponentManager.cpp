@@ -11,16 +11,22 @@
 #include "World.h"
 #include "EventBus.h"
 #include "ParticleSystem.h"
+#include "Tilemap.h"
+#include "Canvas.h"
+#include "Primitives.h"
+#include "RenderStats.h"
+#include "FrameCapture.h"
+#include "EngineUtils.h"
+#include "LuaDispatch.h"
+#include "TagDB.h"
+#include "ActorPool.h"
+#include "ComponentRegistry.h"
 
 
 void ComponentManager::Initialize() {
 	InitializeState();
 }
 
-bool ComponentManager::CompareComponents(const std::shared_ptr<Component> a, const std::shared_ptr<Component> b) {
-	return a->key < b->key;
-}
-
 Component ComponentManager::MakeInstance(std::string type, std::string name) {
 	if (ComponentDB::CheckComponentExists(type)) {
 		Component c = Component(type);
@@ -28,13 +34,15 @@ Component ComponentManager::MakeInstance(std::string type, std::string name) {
 		ComponentDB::EstablishInheritance(c, ComponentDB::globalComponents[type]);
 		c.key = name;
 		c.type = type;
+		c.type_id = ComponentDB::GetTypeID(type);
 		(*c.componentRef)["key"] = c.key;
 		return c;
 	}
-	else if (type == "Rigidbody" || type == "ParticleSystem") {
+	else if (type == "Rigidbody" || type == "ParticleSystem" || type == "Tilemap") {
 		Component c = Component(type);
 		c.key = name;
 		c.type = type;
+		c.type_id = ComponentDB::GetTypeID(type);
 		return c;
 	}
 	else {
@@ -52,9 +60,13 @@ void ComponentManager::InitializeState() {
 
 	luaL_openlibs(lua_state);
 
+	lua_pushcfunction(lua_state, LuaErrorHandler);
+	error_handler_ref = luaL_ref(lua_state, LUA_REGISTRYINDEX);
+
 	luabridge::getGlobalNamespace(lua_state)
 		.beginNamespace("Debug")
 		.addFunction("Log", ComponentManager::CppLog)
+		.addFunction("GetComponentTableCounts", &ComponentDB::GetComponentTableCounts)
 		.endNamespace();
 
 	// --- [ HITRESULT CLASS ] ---
@@ -71,6 +83,7 @@ void ComponentManager::InitializeState() {
 		.beginNamespace("Physics")
 		.addFunction("Raycast", &World::Raycast)
 		.addFunction("RaycastAll", &World::RayCastAll)
+		.addFunction("SetDebugDraw", &Primitives::SetPhysicsDebugDraw)
 		.endNamespace();
 
 	// --- [ EVENTBUS ] ---
@@ -87,7 +100,7 @@ void ComponentManager::InitializeState() {
 		.addData("enabled", &Rigidbody::enabled)
 		.addData("key", &Rigidbody::key)
 		.addData("type", &Rigidbody::type)
-		.addData("actor", &Rigidbody::actor)
+		.addProperty("actor", &ActorPool::GetOwner<Rigidbody>)
 		.addData("x", &Rigidbody::x)
 		.addData("y", &Rigidbody::y)
 		.addData("rotation", &Rigidbody::rotation)
@@ -115,7 +128,7 @@ void ComponentManager::InitializeState() {
 		.addData("enabled", &ParticleSystem::enabled)
 		.addData("key", &ParticleSystem::key)
 		.addData("type", &ParticleSystem::type)
-		.addData("actor", &ParticleSystem::actor)
+		.addProperty("actor", &ActorPool::GetOwner<ParticleSystem>)
 		.addData("x", &ParticleSystem::x)
 		.addData("y", &ParticleSystem::y)
 		.addData("start_color_r", &ParticleSystem::start_color_r)
@@ -131,6 +144,30 @@ void ComponentManager::InitializeState() {
 		.addFunction("Burst", &ParticleSystem::LuaBurst)
 		.endClass();
 
+	// --- [ TILEMAP CLASS ] ---
+	luabridge::getGlobalNamespace(lua_state)
+		.beginClass<Tilemap>("Tilemap")
+		.addData("enabled", &Tilemap::enabled)
+		.addData("key", &Tilemap::key)
+		.addData("type", &Tilemap::type)
+		.addProperty("actor", &ActorPool::GetOwner<Tilemap>)
+		.addData("x", &Tilemap::x)
+		.addData("y", &Tilemap::y)
+		.addData("sorting_order", &Tilemap::sorting_order)
+		.addData("atlas", &Tilemap::atlas)
+		.addData("tile_width", &Tilemap::tile_width)
+		.addData("tile_height", &Tilemap::tile_height)
+		.addData("chunk_size", &Tilemap::chunk_size)
+		.addFunction("AddLayer", &Tilemap::AddLayer)
+		.addFunction("GetTile", &Tilemap::GetTile)
+		.addFunction("SetTile", &Tilemap::SetTile)
+		.addFunction("GetLayerTile", &Tilemap::GetLayerTile)
+		.addFunction("SetLayerTile", &Tilemap::SetLayerTile)
+		.addFunction("GetWidth", &Tilemap::GetWidth)
+		.addFunction("GetHeight", &Tilemap::GetHeight)
+		.addFunction("GetLayerCount", &Tilemap::GetLayerCount)
+		.endClass();
+
 
 	// --- [ COLLISION CLASS ] ---
 	luabridge::getGlobalNamespace(lua_state)
@@ -144,14 +181,20 @@ void ComponentManager::InitializeState() {
 	// --- [ ACTOR CLASS ] ---
 
 	luabridge::getGlobalNamespace(lua_state)
-		.beginClass<Actor>("Actor")
-		.addFunction("GetName", &Actor::GetName)
-		.addFunction("GetID", &Actor::GetID)
-		.addFunction("GetComponent", &Actor::GetComponent)
-		.addFunction("GetComponentByKey", &Actor::GetComponentByKey)
-		.addFunction("GetComponents", &Actor::GetComponents)
-		.addFunction("AddComponent", &Actor::AddComponent)
-		.addFunction("RemoveComponent", &Actor::RemoveComponent)
+		.beginClass<ActorHandle>("Actor")
+		.addFunction("GetName", &ActorHandle::GetName)
+		.addFunction("GetID", &ActorHandle::GetID)
+		.addFunction("IsValid", &ActorHandle::IsValid)
+		.addFunction("GetComponent", &ActorHandle::GetComponent)
+		.addFunction("GetComponentByKey", &ActorHandle::GetComponentByKey)
+		.addFunction("GetComponents", &ActorHandle::GetComponents)
+		.addFunction("HasComponent", &ActorHandle::HasComponent)
+		.addFunction("HasTag", &ActorHandle::HasTag)
+		.addFunction("AddTag", &ActorHandle::AddTag)
+		.addFunction("RemoveTag", &ActorHandle::RemoveTag)
+		.addFunction("AddComponent", &ActorHandle::AddComponent)
+		.addFunction("RemoveComponent", &ActorHandle::RemoveComponent)
+		.addFunction("__eq", &ActorHandle::Equals)
 		.endClass();
 
 	// --- [ ACTOR NAMESPACE ] ---
@@ -159,8 +202,13 @@ void ComponentManager::InitializeState() {
 	luabridge::getGlobalNamespace(lua_state)
 		.beginNamespace("Actor")
 		.addFunction("Find", &SceneDB::Find)
+		.addFunction("FindByID", &SceneDB::FindByID)
 		.addFunction("FindAll", &SceneDB::FindAll)
+		.addFunction("FindAllWithComponent", &ComponentRegistry::FindAllWithComponent)
+		.addFunction("FindAllWithAnyTag", &TagDB::FindAllWithAnyTag)
+		.addFunction("FindAllWithAllTags", &TagDB::FindAllWithAllTags)
 		.addFunction("Instantiate", &SceneDB::Instantiate)
+		.addFunction("InstantiateMany", &SceneDB::InstantiateMany)
 		.addFunction("Destroy", &SceneDB::Destroy)
 		.endNamespace();
 
@@ -237,6 +285,52 @@ void ComponentManager::InitializeState() {
 		.addFunction("Draw", &Renderer::Draw)
 		.addFunction("DrawEx", &Renderer::DrawEx)
 		.addFunction("DrawPixel", &Renderer::DrawPixel)
+		.addFunction("SetStateSorting", &Renderer::SetStateSorting)
+		.addFunction("SetRetainedUI", &Renderer::SetRetainedUI)
+		.addFunction("GetStateChanges", &Renderer::GetStateChanges)
+		.endNamespace();
+
+	// --- [ PRIMITIVES ] ---
+	luabridge::getGlobalNamespace(lua_state)
+		.beginNamespace("Draw")
+		.addFunction("Line", &Primitives::Line)
+		.addFunction("Rect", &Primitives::Rect)
+		.addFunction("Circle", &Primitives::Circle)
+		.addFunction("Polygon", &Primitives::Polygon)
+		.addFunction("LineUI", &Primitives::LineUI)
+		.addFunction("RectUI", &Primitives::RectUI)
+		.addFunction("CircleUI", &Primitives::CircleUI)
+		.addFunction("PolygonUI", &Primitives::PolygonUI)
+		.endNamespace();
+
+	// --- [ CANVAS ] ---
+	luabridge::getGlobalNamespace(lua_state)
+		.beginNamespace("Canvas")
+		.addFunction("SetPixel", &Canvas::SetPixel)
+		.addFunction("BlendPixel", &Canvas::BlendPixel)
+		.addFunction("Fill", &Canvas::Fill)
+		.addFunction("DrawLine", &Canvas::DrawLine)
+		.addFunction("Blit", &Canvas::Blit)
+		.addFunction("Clear", &Canvas::Clear)
+		.addFunction("SetPersistent", &Canvas::SetPersistent)
+		.endNamespace();
+
+	// --- [ RENDER STATS ] ---
+	luabridge::getGlobalNamespace(lua_state)
+		.beginNamespace("RenderStats")
+		.addFunction("Get", &RenderStats::Get)
+		.addFunction("GetTotal", &RenderStats::GetTotal)
+		.addFunction("SetOverlay", &RenderStats::SetOverlay)
+		.endNamespace();
+
+	// --- [ FRAME CAPTURE ] ---
+	luabridge::getGlobalNamespace(lua_state)
+		.beginNamespace("Capture")
+		.addFunction("Start", &FrameCapture::Start)
+		.addFunction("Stop", &FrameCapture::Stop)
+		.addFunction("IsCapturing", &FrameCapture::IsCapturing)
+		.addFunction("GetDroppedFrames", &FrameCapture::GetDroppedFrames)
+		.addFunction("GetWrittenFrames", &FrameCapture::GetWrittenFrames)
 		.endNamespace();
 
 	// --- [ CAM ] ---
@@ -247,6 +341,8 @@ void ComponentManager::InitializeState() {
 		.addFunction("GetPositionY", &Renderer::GetPositionY)
 		.addFunction("SetZoom", &Renderer::SetZoom)
 		.addFunction("GetZoom", &Renderer::GetZoom)
+		.addFunction("GetResolutionScale", &Renderer::GetResolutionScale)
+		.addFunction("SetHiddenTags", &Renderer::SetHiddenTags)
 		.endNamespace();
 
 	// --- [ SCENE ] ---
@@ -259,9 +355,68 @@ void ComponentManager::InitializeState() {
 
 
 	ComponentDB::Initialize(lua_state);
+	LuaDispatch::Initialize();
 }
 
 
+// --- [ LIFECYCLE DISPATCH ] ---
+
+int ComponentManager::LuaErrorHandler(lua_State* L) {
+	if (lua_type(L, 1) != LUA_TSTRING) {
+		luaL_tolstring(L, 1, nullptr);
+	}
+	return 1;
+}
+
+void ComponentManager::CopyFields(int from, int to) {
+	from = lua_absindex(lua_state, from);
+	to = lua_absindex(lua_state, to);
+
+	// Clearing existing fields during traversal is allowed
+	lua_pushnil(lua_state);
+	while (lua_next(lua_state, to) != 0) {
+		lua_pop(lua_state, 1);
+		lua_pushvalue(lua_state, -1);
+		lua_pushnil(lua_state);
+		lua_rawset(lua_state, to);
+	}
+	lua_pushnil(lua_state);
+	while (lua_next(lua_state, from) != 0) {
+		lua_pushvalue(lua_state, -2);
+		lua_insert(lua_state, -2);
+		lua_rawset(lua_state, to);
+	}
+}
+
+int ComponentManager::RefFunction(luabridge::LuaRef& component, const char* function_name) {
+	component.push(lua_state);
+	// Goes through __index, so functions inherited from the component type are found too
+	lua_getfield(lua_state, -1, function_name);
+	int ref = LUA_NOREF;
+	if (lua_isfunction(lua_state, -1)) {
+		ref = luaL_ref(lua_state, LUA_REGISTRYINDEX);
+	}
+	else {
+		lua_pop(lua_state, 1);
+	}
+	lua_pop(lua_state, 1);
+	return ref;
+}
+
+int ComponentManager::PushErrorHandler() {
+	lua_rawgeti(lua_state, LUA_REGISTRYINDEX, error_handler_ref);
+	return lua_gettop(lua_state);
+}
+
+void ComponentManager::CallLifecycle(int function_ref, Component& c, const std::string& actor_name, int error_handler_index) {
+	lua_rawgeti(lua_state, LUA_REGISTRYINDEX, function_ref);
+	c.componentRef->push(lua_state);
+	if (lua_pcall(lua_state, 1, 0, error_handler_index) != LUA_OK) {
+		EngineUtils::ReportError(actor_name, std::string(lua_tostring(lua_state, -1)));
+		lua_pop(lua_state, 1);
+	}
+}
+
 void ComponentManager::CppLog(const std::string& message) {
 	std::cout << message << std::endl;
 }
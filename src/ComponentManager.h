@@ -16,13 +16,32 @@ public:
 	static void Initialize();
 	inline static lua_State* lua_state;
 	static Component MakeInstance(std::string type, std::string name);
-	static bool CompareComponents(const std::shared_ptr<Component> a, const std::shared_ptr<Component> b);
 	static void InitializeState();
 	static void InitializeFunctions();
 	static void InitializeComponents();
 
 	static Component CreateRigidbody();
 
+	// --- [ LIFECYCLE DISPATCH ] ---
+
+	// Registry reference to LuaErrorHandler, used as the message handler of every lifecycle call
+	inline static int error_handler_ref = LUA_NOREF;
+
+	// Turns any error value into a message string
+	static int LuaErrorHandler(lua_State* L);
+
+	// Makes the raw fields of the table at [to] those of the table at [from], removing any others
+	static void CopyFields(int from, int to);
+
+	// Returns a registry reference to component[function_name] if it is a function, otherwise LUA_NOREF
+	static int RefFunction(luabridge::LuaRef& component, const char* function_name);
+
+	// Pushes the error handler and returns its stack index, pop it once dispatching is done
+	static int PushErrorHandler();
+
+	// Calls the referenced function with the component as self, reporting errors under actor_name
+	static void CallLifecycle(int function_ref, Component& c, const std::string& actor_name, int error_handler_index);
+
 	// --- [ LUA LOG FUNCTIONS ] ---
 	static void CppLog(const std::string& message);
 	static void CppLogError(const std::string& message);
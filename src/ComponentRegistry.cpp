@@ -0,0 +1,113 @@
+#include "ComponentRegistry.h"
+#include "Actor.h"
+#include "ActorPool.h"
+#include "ComponentDB.h"
+#include "ComponentManager.h"
+#include <algorithm>
+
+void ComponentRegistry::Add(Actor* a, int type_id) {
+	if (type_id >= static_cast<int>(members.size())) {
+		members.resize(ComponentDB::GetTypeCount());
+	}
+	TypeMembers& type_members = members[type_id];
+	if (a->pool_slot >= type_members.sparse.size()) {
+		type_members.sparse.resize(a->pool_slot + 1);
+	}
+	// The last member is never a hole, Remove pops trailing ones
+	if (type_members.dense.empty() || type_members.dense.back()->id < a->id) {
+		type_members.sparse[a->pool_slot] = static_cast<uint32_t>(type_members.dense.size());
+		type_members.dense.push_back(a);
+		return;
+	}
+	// An older actor gaining the type, rare enough to shift the members after it
+	Compact(type_members);
+	auto position = std::lower_bound(type_members.dense.begin(), type_members.dense.end(), a, [](const Actor* x, const Actor* y) {
+		return x->id < y->id; });
+	size_t index = position - type_members.dense.begin();
+	type_members.dense.insert(position, a);
+	for (size_t i = index; i < type_members.dense.size(); i++) {
+		type_members.sparse[type_members.dense[i]->pool_slot] = static_cast<uint32_t>(i);
+	}
+}
+
+void ComponentRegistry::Remove(Actor* a, int type_id) {
+	if (type_id < 0 || type_id >= static_cast<int>(members.size())) {
+		return;
+	}
+	TypeMembers& type_members = members[type_id];
+	if (a->pool_slot >= type_members.sparse.size()) {
+		return;
+	}
+	uint32_t index = type_members.sparse[a->pool_slot];
+	if (index >= type_members.dense.size() || type_members.dense[index] != a) {
+		return;
+	}
+	if (index + 1 < type_members.dense.size()) {
+		// Leave a hole so the members after it keep their place and order
+		type_members.dense[index] = nullptr;
+		type_members.holes++;
+		if (type_members.holes * 2 > static_cast<int>(type_members.dense.size())) {
+			Compact(type_members);
+		}
+		return;
+	}
+	type_members.dense.pop_back();
+	while (!type_members.dense.empty() && type_members.dense.back() == nullptr) {
+		type_members.dense.pop_back();
+		type_members.holes--;
+	}
+}
+
+void ComponentRegistry::RemoveActor(Actor* a) {
+	for (size_t word = 0; word < a->component_mask.size(); word++) {
+		for (int bit = 0; bit < 64; bit++) {
+			if (a->component_mask[word] & (uint64_t(1) << bit)) {
+				Remove(a, static_cast<int>(word * 64 + bit));
+			}
+		}
+	}
+}
+
+void ComponentRegistry::AddActor(Actor* a) {
+	for (size_t word = 0; word < a->component_mask.size(); word++) {
+		for (int bit = 0; bit < 64; bit++) {
+			if (a->component_mask[word] & (uint64_t(1) << bit)) {
+				Add(a, static_cast<int>(word * 64 + bit));
+			}
+		}
+	}
+}
+
+// --- [ LUA FUNCTIONS ] ---
+
+luabridge::LuaRef ComponentRegistry::FindAllWithComponent(std::string type_name) {
+	lua_State* lua_state = ComponentManager::lua_state;
+	luabridge::LuaRef table = luabridge::newTable(lua_state);
+
+	int type_id = ComponentDB::GetTypeID(type_name);
+	if (type_id < 0 || type_id >= static_cast<int>(members.size())) {
+		return table;
+	}
+	TypeMembers& type_members = members[type_id];
+	if (type_members.holes > 0) {
+		Compact(type_members);
+	}
+	int i = 1;
+	for (Actor* a : type_members.dense) {
+		if (!a->deleted) {
+			// Lua tables are 1-indexed
+			table[i++] = luabridge::LuaRef(lua_state, ActorPool::GetHandle(a));
+		}
+	}
+	return table;
+}
+
+// --- [ HELPER FUNCTIONS ] ---
+
+void ComponentRegistry::Compact(TypeMembers& type_members) {
+	type_members.dense.erase(std::remove(type_members.dense.begin(), type_members.dense.end(), nullptr), type_members.dense.end());
+	for (size_t i = 0; i < type_members.dense.size(); i++) {
+		type_members.sparse[type_members.dense[i]->pool_slot] = static_cast<uint32_t>(i);
+	}
+	type_members.holes = 0;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "lua.hpp"
+#include "LuaBridge/LuaBridge.h"
+
+class Actor;
+
+// Which actors hold at least one component of each type. Every type keeps a sparse set keyed by
+// actor pool slot whose members stay in actor id order: new actors have the highest ids and are
+// appended, and removals leave holes that the next query (or too many holes) compacts in order.
+class ComponentRegistry
+{
+public:
+	// Called by Actor when it gains its first component of [type_id]
+	static void Add(Actor* a, int type_id);
+
+	// Called by Actor when it loses its last component of [type_id]
+	static void Remove(Actor* a, int type_id);
+
+	// Drops an actor from every type it is a member of, call before releasing it
+	static void RemoveActor(Actor* a);
+
+	// Adds an actor back to every type in its component mask, for actors reused by TemplatePool
+	static void AddActor(Actor* a);
+
+	// --- [ LUA FUNCTIONS ] ---
+
+	// Returns every live actor holding a component of [type_name], in id order
+	static luabridge::LuaRef FindAllWithComponent(std::string type_name);
+
+private:
+	struct TypeMembers {
+		// Sorted by actor id, removed members are nullptr until compacted
+		std::vector<Actor*> dense;
+		int holes = 0;
+
+		// Actor pool slot -> index in dense, only valid for slots whose actor is in dense
+		std::vector<uint32_t> sparse;
+	};
+
+	// Indexed by type ID
+	inline static std::vector<TypeMembers> members;
+
+	// Drops the holes from a type's members, keeping id order, and fixes their sparse entries
+	static void Compact(TypeMembers& type_members);
+};
@@ -8,6 +8,12 @@
 #include "Input.h"
 #include "World.h"
 #include "EventBus.h"
+#include "Primitives.h"
+#include "RenderStats.h"
+#include "GoldenFrames.h"
+#include "FrameCapture.h"
+#include "LuaDispatch.h"
+#include "TagDB.h"
 
 
 
@@ -22,6 +28,14 @@ void Engine::GetGameConfig() {
 		exit(0);
 	}
 	EngineUtils::ReadJsonFile("./resources/game.config", game_config);
+	if (game_config.HasMember("lua_dispatch")) {
+		std::string lua_dispatch = game_config["lua_dispatch"].GetString();
+		if (lua_dispatch != "per_type" && lua_dispatch != "per_actor") {
+			std::cout << "error: unknown lua_dispatch " << lua_dispatch;
+			exit(0);
+		}
+		LuaDispatch::per_type = lua_dispatch == "per_type";
+	}
 }
 
 void Engine::GetRenderConfig() {
@@ -45,6 +59,82 @@ void Engine::GetRenderConfig() {
 		if (render_config.HasMember("zoom_factor")) {
 			Renderer::zoom_factor = render_config["zoom_factor"].GetFloat();
 		}
+		if (render_config.HasMember("renderer_backend")) {
+			Renderer::backend = render_config["renderer_backend"].GetString();
+			if (Renderer::backend != "gpu" && Renderer::backend != "software") {
+				std::cout << "error: unknown renderer_backend " << Renderer::backend;
+				exit(0);
+			}
+		}
+		if (render_config.HasMember("max_frames")) {
+			max_frames = render_config["max_frames"].GetInt();
+		}
+		if (render_config.HasMember("golden_frames")) {
+			GoldenFrames::directory = render_config["golden_frames"].GetString();
+		}
+		if (render_config.HasMember("golden_record")) {
+			GoldenFrames::record = render_config["golden_record"].GetBool();
+		}
+		if (render_config.HasMember("golden_every")) {
+			GoldenFrames::every = std::max(1, render_config["golden_every"].GetInt());
+		}
+		if (render_config.HasMember("golden_tolerance")) {
+			GoldenFrames::tolerance = render_config["golden_tolerance"].GetInt();
+		}
+		if (render_config.HasMember("capture")) {
+			capture_on_start = render_config["capture"].GetBool();
+		}
+		if (render_config.HasMember("capture_directory")) {
+			FrameCapture::directory = render_config["capture_directory"].GetString();
+		}
+		if (render_config.HasMember("capture_format")) {
+			FrameCapture::format = render_config["capture_format"].GetString();
+		}
+		if (render_config.HasMember("capture_every")) {
+			FrameCapture::every = std::max(1, render_config["capture_every"].GetInt());
+		}
+		if (render_config.HasMember("capture_buffers")) {
+			FrameCapture::buffer_count = std::max(1, render_config["capture_buffers"].GetInt());
+		}
+		if (render_config.HasMember("resolution_scale")) {
+			Renderer::render_scale = glm::clamp(render_config["resolution_scale"].GetFloat(), 0.1f, 1.0f);
+		}
+		if (render_config.HasMember("dynamic_resolution")) {
+			Renderer::dynamic_resolution = render_config["dynamic_resolution"].GetBool();
+		}
+		if (render_config.HasMember("dynamic_resolution_budget_ms")) {
+			Renderer::dynamic_resolution_budget_ms = render_config["dynamic_resolution_budget_ms"].GetFloat();
+		}
+		if (render_config.HasMember("dynamic_resolution_min_scale")) {
+			Renderer::dynamic_resolution_min_scale = glm::clamp(render_config["dynamic_resolution_min_scale"].GetFloat(), 0.1f, 1.0f);
+		}
+		if (render_config.HasMember("hidden_tags")) {
+			Renderer::hidden_tags = TagDB::ParseMask(render_config["hidden_tags"]);
+		}
+		if (render_config.HasMember("retained_ui")) {
+			Renderer::retained_ui = render_config["retained_ui"].GetBool();
+		}
+		if (render_config.HasMember("retained_ui_max_layers")) {
+			Renderer::retained_ui_max_layers = render_config["retained_ui_max_layers"].GetInt();
+		}
+		if (render_config.HasMember("sort_by_render_state")) {
+			Renderer::sort_by_render_state = render_config["sort_by_render_state"].GetBool();
+		}
+		if (render_config.HasMember("stats_overlay")) {
+			RenderStats::overlay_enabled = render_config["stats_overlay"].GetBool();
+		}
+		if (render_config.HasMember("stats_overlay_font")) {
+			RenderStats::overlay_font = render_config["stats_overlay_font"].GetString();
+		}
+		if (render_config.HasMember("stats_overlay_font_size")) {
+			RenderStats::overlay_font_size = render_config["stats_overlay_font_size"].GetInt();
+		}
+		if (render_config.HasMember("stats_csv")) {
+			RenderStats::OpenCSV(render_config["stats_csv"].GetString());
+		}
+		if (render_config.HasMember("physics_debug_draw")) {
+			Primitives::physics_debug_draw_enabled = render_config["physics_debug_draw"].GetBool();
+		}
 	}
 }
 
@@ -52,9 +142,24 @@ void Engine::StartRenderer() {
 	if (game_config.HasMember("game_title")) {
 		Renderer::game_title = game_config["game_title"].GetString();
 	}
+	// Headless and fixed-length runs go as fast as they can instead of at 60 fps
+	Helper::_unpaced_mode = Renderer::backend == "software" || max_frames > 0;
 	Renderer::makeWindow();
 	Renderer::makeRenderer();
 	Renderer::clear();
+
+	// Recorded and autograded frames go through the capture writer thread instead of Helper's synchronous save
+	if (Helper::IsRecordingFrames()) {
+		FrameCapture::directory = Helper::frame_directory_relative_path;
+		FrameCapture::format = "bmp";
+		FrameCapture::every = 1;
+		FrameCapture::drop_frames = false;
+		FrameCapture::Start();
+		Helper::_external_frame_capture = true;
+	}
+	else if (capture_on_start) {
+		FrameCapture::Start();
+	}
 }
 
 void Engine::LoadImages() {
@@ -105,12 +210,22 @@ void Engine::Update(SDL_Event& next_event)
 	}
 	SceneDB::OnStartActorQueue.clear();
 
-	for (Actor* actor : SceneDB::OnUpdateActorQueue) {
-		actor->Update();
+	if (LuaDispatch::per_type) {
+		// Natives still update per actor, then each Lua component type updates in one call
+		for (Actor* actor : SceneDB::OnUpdateActorQueue) {
+			actor->Update(false);
+		}
+		LuaDispatch::Update();
+		LuaDispatch::LateUpdate();
 	}
+	else {
+		for (Actor* actor : SceneDB::OnUpdateActorQueue) {
+			actor->Update();
+		}
 
-	for (Actor* actor : SceneDB::OnLateUpdateActorQueue) {
-		actor->LateUpdate();
+		for (Actor* actor : SceneDB::OnLateUpdateActorQueue) {
+			actor->LateUpdate();
+		}
 	}
 
 	// Removals and updates
@@ -119,6 +234,7 @@ void Engine::Update(SDL_Event& next_event)
 
 void Engine::Render()
 {
+	Uint64 render_start = SDL_GetPerformanceCounter();
 	Renderer::clear();
 	// Render scene_space images
 	Renderer::FlushImageAndRender();
@@ -132,8 +248,24 @@ void Engine::Render()
 	// Render pixels
 	Renderer::FlushPixelAndRender();
 
-	// Flip buffer
+	// The readbacks below are not part of the frame's render cost
+	Uint64 render_ticks = SDL_GetPerformanceCounter() - render_start;
+
+	// Read the frame back before the overlay is drawn and before presenting, which leaves the back buffer undefined
+	GoldenFrames::OnFrameRendered(Renderer::renderer);
+	FrameCapture::CaptureFrame(Renderer::renderer);
+
+	// Stats overlay and counters
+	Uint64 present_start = SDL_GetPerformanceCounter();
+	Renderer::EndFrame();
+
+	// Flip buffer. SDL runs the batched draws at present, which is the fill cost render_scale lowers,
+	// but the sleep Helper adds to pace the frame is not render cost.
 	Helper::SDL_RenderPresent(Renderer::renderer);
+	render_ticks += SDL_GetPerformanceCounter() - present_start - Helper::last_delay_ticks;
+
+	float render_ms = static_cast<float>(render_ticks) * 1000.0f / static_cast<float>(SDL_GetPerformanceFrequency());
+	Renderer::UpdateResolutionScale(render_ms);
 }
 
 
@@ -153,7 +285,16 @@ void Engine::GameLoop()
 		EventBus::UpdateSubs();
 		World::Step();
 		Render();
+
+		// Headless runs stop on their own after a fixed number of frames
+		frames_rendered++;
+		if (max_frames > 0 && frames_rendered >= max_frames) {
+			quit = true;
+			running = false;
+		}
 	}
+	GoldenFrames::PrintSummary();
+	FrameCapture::Stop();
 	if (quit) {
 		exit(0);
 	}
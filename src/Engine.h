@@ -54,6 +54,13 @@ private:
 	bool quit = false;
 	std::string next_scene = "";
 
+	// Quits after this many frames when above 0 (for headless runs)
+	int max_frames = 0;
+	int frames_rendered = 0;
+
+	// Starts FrameCapture once the renderer exists
+	bool capture_on_start = false;
+
 	// -----------[INPUT]------------------
 	std::string input = "";
 };
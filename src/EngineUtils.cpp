@@ -64,7 +64,11 @@ bool ActorComp::operator()(Actor* a, Actor* b) const {
 }
 
 void EngineUtils::ReportError(const std::string& actor_name, const luabridge::LuaException& e) {
-	std::string error_message = e.what();
+	ReportError(actor_name, std::string(e.what()));
+}
+
+void EngineUtils::ReportError(const std::string& actor_name, const std::string& message) {
+	std::string error_message = message;
 
 	// Normalize file paths across platforms
 	std::replace(error_message.begin(), error_message.end(), '\\', '/');
@@ -31,5 +31,7 @@ public:
 	static std::string obtain_word_after_phrase(const std::string& input, const std::string& phrase);
 
 	static void ReportError(const std::string& actor_name, const luabridge::LuaException& e);
+
+	static void ReportError(const std::string& actor_name, const std::string& message);
 };
 
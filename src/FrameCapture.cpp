@@ -0,0 +1,182 @@
+#include "FrameCapture.h"
+#include "SDL2_image/SDL_image.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+void FrameCapture::Start() {
+	if (capturing) {
+		return;
+	}
+	if (format != "bmp" && format != "png" && format != "raw") {
+		std::cout << "error: unknown capture_format " << format;
+		exit(0);
+	}
+	std::filesystem::create_directories(directory);
+
+	// The buffers are sized on the first captured frame
+	buffers.assign(std::max(1, buffer_count), CaptureBuffer());
+	free_buffers.clear();
+	pending_buffers.clear();
+	for (int i = 0; i < static_cast<int>(buffers.size()); i++) {
+		free_buffers.push_back(i);
+	}
+	width = 0;
+	height = 0;
+	frame = 0;
+	dropped_frames = 0;
+	written_frames = 0;
+
+	stopping = false;
+	capturing = true;
+	writer = std::thread(WriterLoop);
+
+	// The writer has to be joined before static objects are destroyed, even when the game quits via exit()
+	static bool registered = false;
+	if (!registered) {
+		std::atexit(Stop);
+		registered = true;
+	}
+}
+
+void FrameCapture::Stop() {
+	if (!capturing) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	buffers_pending.notify_one();
+	writer.join();
+	capturing = false;
+	if (dropped_frames > 0) {
+		std::cout << "frame capture: " << written_frames << " frames written, " << dropped_frames << " dropped" << std::endl;
+	}
+}
+
+void FrameCapture::CaptureFrame(SDL_Renderer* renderer) {
+	if (!capturing) {
+		return;
+	}
+	int current_frame = frame++;
+	if (current_frame % std::max(1, every) != 0) {
+		return;
+	}
+
+	if (width == 0) {
+		SDL_GetRendererOutputSize(renderer, &width, &height);
+		for (CaptureBuffer& buffer : buffers) {
+			buffer.pixels.resize(static_cast<size_t>(width) * height * 4);
+		}
+	}
+
+	int index = -1;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!drop_frames) {
+			buffers_free.wait(lock, [] { return !free_buffers.empty(); });
+		}
+		else if (free_buffers.empty()) {
+			// The writer is behind, skip this frame rather than wait for it
+			dropped_frames++;
+			return;
+		}
+		index = free_buffers.back();
+		free_buffers.pop_back();
+	}
+
+	// The read back itself has to happen on the rendering thread
+	CaptureBuffer& buffer = buffers[index];
+	buffer.frame = current_frame;
+	if (SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_RGBA32, buffer.pixels.data(), width * 4) != 0) {
+		std::lock_guard<std::mutex> lock(mutex);
+		free_buffers.push_back(index);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending_buffers.push_back(index);
+	}
+	buffers_pending.notify_one();
+}
+
+int FrameCapture::GetDroppedFrames() {
+	return dropped_frames;
+}
+
+int FrameCapture::GetWrittenFrames() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return written_frames;
+}
+
+bool FrameCapture::IsCapturing() {
+	return capturing;
+}
+
+void FrameCapture::WriterLoop() {
+	if (format == "raw") {
+		raw_file.open(directory + "/capture.raw", std::ios::out | std::ios::binary | std::ios::trunc);
+	}
+	while (true) {
+		int index = -1;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			buffers_pending.wait(lock, [] { return stopping || !pending_buffers.empty(); });
+			if (pending_buffers.empty()) {
+				// Only exits once everything queued has been written
+				break;
+			}
+			index = pending_buffers.front();
+			pending_buffers.pop_front();
+		}
+
+		WriteBuffer(buffers[index]);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			free_buffers.push_back(index);
+			written_frames++;
+		}
+		buffers_free.notify_one();
+	}
+	if (raw_file.is_open()) {
+		raw_file.close();
+
+		// Everything needed to decode the raw file, e.g. ffmpeg -f rawvideo -pixel_format rgba -video_size WxH
+		std::ofstream info(directory + "/capture.txt", std::ios::out | std::ios::trunc);
+		info << "width " << width << "\nheight " << height << "\npixel_format rgba\nevery " << every << "\n";
+	}
+}
+
+void FrameCapture::WriteBuffer(CaptureBuffer& buffer) {
+	if (format == "raw") {
+		raw_file.write(reinterpret_cast<const char*>(buffer.pixels.data()), static_cast<std::streamsize>(buffer.pixels.size()));
+		return;
+	}
+
+	std::stringstream path;
+	path << directory << "/frame_" << std::setw(5) << std::setfill('0') << buffer.frame << "." << format;
+
+	// Wraps the buffer without copying it
+	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(buffer.pixels.data(), width, height, 32, width * 4, SDL_PIXELFORMAT_RGBA32);
+	if (surface == nullptr) {
+		return;
+	}
+	if (format == "png") {
+		IMG_SavePNG(surface, path.str().c_str());
+	}
+	else {
+		// 24 bit like Helper's own recordings, so frames compare equal to ones it wrote
+		SDL_Surface* rgb = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGB24, 0);
+		SDL_SaveBMP(rgb != nullptr ? rgb : surface, path.str().c_str());
+		if (rgb != nullptr) {
+			SDL_FreeSurface(rgb);
+		}
+	}
+	SDL_FreeSurface(surface);
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "SDL2/SDL.h"
+
+// Writes rendered frames to disk without stalling the game loop.
+// Frames are read back into a fixed pool of buffers and written by a background thread,
+// when every buffer is still waiting to be written the frame is dropped and counted instead.
+class FrameCapture
+{
+public:
+	// Starts the writer thread, frames are captured from the next CaptureFrame on
+	static void Start();
+
+	// Writes every queued frame and stops the writer thread
+	static void Stop();
+
+	// Reads the current frame into a free buffer and queues it, call before presenting
+	static void CaptureFrame(SDL_Renderer* renderer);
+
+	// --- [ LUA FUNCTIONS ] ---
+
+	// Returns the number of frames dropped because no buffer was free
+	static int GetDroppedFrames();
+
+	// Returns the number of frames written so far
+	static int GetWrittenFrames();
+
+	// Returns whether frames are being captured
+	static bool IsCapturing();
+
+	// ---- [ CONFIG ] ----
+
+	// Directory (relative to the working directory) the capture is written to
+	inline static std::string directory = "captures";
+
+	// "bmp" or "png" image sequence, or "raw" for all frames concatenated into one RGBA file
+	inline static std::string format = "bmp";
+
+	// Only every Nth frame is captured
+	inline static int every = 1;
+
+	// Number of frames that can wait for the writer thread before frames are dropped
+	inline static int buffer_count = 4;
+
+	// When false, a frame waits for the writer instead of being dropped (recordings that must have every frame)
+	inline static bool drop_frames = true;
+
+private:
+	struct CaptureBuffer {
+		std::vector<uint8_t> pixels;
+		int frame = 0;
+	};
+
+	inline static std::vector<CaptureBuffer> buffers;
+
+	// Indices into buffers, guarded by mutex
+	inline static std::vector<int> free_buffers;
+	inline static std::deque<int> pending_buffers;
+
+	inline static std::mutex mutex;
+	inline static std::condition_variable buffers_pending;
+	inline static std::condition_variable buffers_free;
+	inline static std::thread writer;
+	inline static bool capturing = false;
+	inline static bool stopping = false;
+
+	inline static int width = 0;
+	inline static int height = 0;
+	inline static int frame = 0;
+	inline static int dropped_frames = 0;
+	inline static int written_frames = 0;
+
+	// Output of the raw format, only touched by the writer thread
+	inline static std::ofstream raw_file;
+
+	// Waits for pending buffers and writes them until stopped
+	static void WriterLoop();
+
+	// Writes one frame in the configured format
+	static void WriteBuffer(CaptureBuffer& buffer);
+};
@@ -0,0 +1,99 @@
+#include "GoldenFrames.h"
+#include "EngineUtils.h"
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+void GoldenFrames::OnFrameRendered(SDL_Renderer* renderer) {
+	int current_frame = frame++;
+	if (directory.empty() || current_frame % every != 0) {
+		return;
+	}
+	std::string folder = "resources/" + directory;
+	std::string path = folder + "/frame_" + std::to_string(current_frame) + ".bmp";
+
+	if (record) {
+		SDL_Surface* frame_surface = ReadFrame(renderer);
+		if (frame_surface == nullptr) {
+			return;
+		}
+		std::filesystem::create_directories(folder);
+		SDL_SaveBMP(frame_surface, path.c_str());
+		SDL_FreeSurface(frame_surface);
+		return;
+	}
+
+	if (!EngineUtils::CheckPathExists(path)) {
+		return;
+	}
+	SDL_Surface* loaded = SDL_LoadBMP(path.c_str());
+	if (loaded == nullptr) {
+		std::cout << "error: could not load golden frame " << path << std::endl;
+		return;
+	}
+	SDL_Surface* golden_surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+	SDL_FreeSurface(loaded);
+	SDL_Surface* frame_surface = ReadFrame(renderer);
+	if (golden_surface == nullptr || frame_surface == nullptr) {
+		SDL_FreeSurface(golden_surface);
+		SDL_FreeSurface(frame_surface);
+		return;
+	}
+
+	compared++;
+	int differences = CountDifferences(frame_surface, golden_surface);
+	if (differences != 0) {
+		mismatched++;
+		if (differences < 0) {
+			std::cout << "golden mismatch: frame " << current_frame << " size differs from " << path << std::endl;
+		}
+		else {
+			std::cout << "golden mismatch: frame " << current_frame << " has " << differences << " differing pixels" << std::endl;
+		}
+	}
+	SDL_FreeSurface(golden_surface);
+	SDL_FreeSurface(frame_surface);
+}
+
+void GoldenFrames::PrintSummary() {
+	if (directory.empty() || record) {
+		return;
+	}
+	std::cout << "golden frames: " << compared << " compared, " << mismatched << " mismatched" << std::endl;
+}
+
+SDL_Surface* GoldenFrames::ReadFrame(SDL_Renderer* renderer) {
+	int width = 0;
+	int height = 0;
+	SDL_GetRendererOutputSize(renderer, &width, &height);
+	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+	if (surface == nullptr) {
+		return nullptr;
+	}
+	if (SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_RGBA32, surface->pixels, surface->pitch) != 0) {
+		SDL_FreeSurface(surface);
+		return nullptr;
+	}
+	return surface;
+}
+
+int GoldenFrames::CountDifferences(SDL_Surface* frame_surface, SDL_Surface* golden_surface) {
+	if (frame_surface->w != golden_surface->w || frame_surface->h != golden_surface->h) {
+		return -1;
+	}
+	int differences = 0;
+	for (int y = 0; y < frame_surface->h; y++) {
+		const Uint8* a = static_cast<const Uint8*>(frame_surface->pixels) + y * frame_surface->pitch;
+		const Uint8* b = static_cast<const Uint8*>(golden_surface->pixels) + y * golden_surface->pitch;
+		for (int x = 0; x < frame_surface->w; x++) {
+			// BMP files carry no alpha, so only color channels are compared
+			for (int c = 0; c < 3; c++) {
+				if (std::abs(a[x * 4 + c] - b[x * 4 + c]) > tolerance) {
+					differences++;
+					break;
+				}
+			}
+		}
+	}
+	return differences;
+}
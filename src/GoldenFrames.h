@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include "SDL2/SDL.h"
+
+// Compares (or records) rendered frames against BMP files in resources/[directory] named frame_[N].bmp.
+// Only frames that have a golden file are compared, so a test can keep just the frames it cares about.
+class GoldenFrames
+{
+public:
+	// Checks or records the frame that was just rendered, call before presenting
+	static void OnFrameRendered(SDL_Renderer* renderer);
+
+	// Prints how many frames were compared and how many did not match
+	static void PrintSummary();
+
+	// ---- [ CONFIG ] ----
+
+	// Directory inside resources, comparisons are off while empty
+	inline static std::string directory = "";
+
+	// Writes frames instead of comparing them
+	inline static bool record = false;
+
+	// Only every Nth frame is checked or recorded
+	inline static int every = 1;
+
+	// Largest per channel difference still counted as a match
+	inline static int tolerance = 0;
+
+private:
+	inline static int frame = 0;
+	inline static int compared = 0;
+	inline static int mismatched = 0;
+
+	// Reads the renderer output into an RGBA32 surface, nullptr on failure
+	static SDL_Surface* ReadFrame(SDL_Renderer* renderer);
+
+	// Returns the number of pixels differing by more than tolerance, or -1 if the sizes differ
+	static int CountDifferences(SDL_Surface* frame_surface, SDL_Surface* golden_surface);
+};
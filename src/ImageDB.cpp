@@ -4,6 +4,7 @@
 #include <iostream>
 #include "EngineUtils.h"
 #include "Helper.h"
+#include <algorithm>
 
 std::vector<std::string> ImageDB::introImages;
 
@@ -11,9 +12,16 @@ void ImageDB::Initialize() {
 	// iterate through all loadable assets and load them
 	const std::string images_directory_path = "resources/images";
 	if (std::filesystem::exists(images_directory_path)) {
+		// Sorted so the IDs follow the names and do not depend on the file system
+		std::vector<std::filesystem::path> image_paths;
 		for (const auto& image : std::filesystem::directory_iterator(images_directory_path)) {
+			image_paths.push_back(image.path());
+		}
+		std::sort(image_paths.begin(), image_paths.end());
+
+		for (const auto& image_path : image_paths) {
 			// load images
-			std::string name = image.path().filename().stem().string();
+			std::string name = image_path.filename().stem().string();
 			std::string image_location = images_directory_path + "/" + name + ".png";
 			SDL_Texture* img = IMG_LoadTexture(Renderer::renderer, image_location.c_str());
 			if (img == nullptr) {
@@ -21,10 +29,16 @@ void ImageDB::Initialize() {
 				exit(0);
 			}
 			images[name] = img;
+			image_ids[img] = static_cast<int>(image_ids.size());
 		}
 	}
 }
 
+int ImageDB::GetImageID(SDL_Texture* tex) {
+	auto itr = image_ids.find(tex);
+	return itr == image_ids.end() ? -1 : itr->second;
+}
+
 SDL_Texture* ImageDB::GetImage(std::string name) {
 	auto itr = images.find(name);
 	if (itr == images.end()) {
@@ -99,4 +113,5 @@ void ImageDB::CreateDefaultParticleTextureWithName(const std::string& name) {
 	// Clean up the surface and cache the texture for future default particle spawning
 	SDL_FreeSurface(surface);
 	images[name] = texture;
+	image_ids[texture] = static_cast<int>(image_ids.size());
 }
\ No newline at end of file
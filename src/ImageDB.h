@@ -20,12 +20,18 @@ public:
 
 	static inline std::unordered_map<std::string, SDL_Texture*> images;
 
+	// Texture -> ID in image name order, a sort key that does not depend on allocation addresses
+	static inline std::unordered_map<SDL_Texture*, int> image_ids;
+
 	// Reads in all textures in the resources folder.
 	static void Initialize();
 
 	// Returns a pointer to the texture or a nullptr if not found in the database.
 	static SDL_Texture* GetImage(std::string name);
 
+	// Returns the stable ID of a loaded texture, or -1 for nullptr and textures ImageDB did not make
+	static int GetImageID(SDL_Texture* tex);
+
 	// A deprecated function from earlier versions of the engine
 	static void SetIntroImages(rapidjson::GenericArray<false, rapidjson::Value>& images);
 
@@ -0,0 +1,288 @@
+#include "LuaDispatch.h"
+#include "Actor.h"
+#include "ComponentDB.h"
+#include "ComponentManager.h"
+#include "EngineUtils.h"
+#include "ActorPool.h"
+#include <algorithm>
+
+// driver(instances, f, handler, report) calls f(c) on every instance, reporting errors instead of stopping.
+// Disabling or removing an instance leaves a false in its place right away, even during the pass, so the
+// driver never reads the Lua enabled field and runs exactly what per actor dispatch would.
+static const char* driver_source = R"(
+local xpcall = xpcall
+return function(instances, f, handler, report)
+	for i = 1, #instances do
+		local c = instances[i]
+		if c then
+			local ok, err = xpcall(f, handler, c)
+			if not ok then
+				report(c, err)
+			end
+		end
+	end
+end
+)";
+
+void LuaDispatch::Initialize() {
+	lua_State* lua_state = ComponentManager::lua_state;
+	if (luaL_dostring(lua_state, driver_source) != LUA_OK) {
+		std::cout << "error: could not compile the lua dispatch driver: " << lua_tostring(lua_state, -1);
+		exit(0);
+	}
+	driver_ref = luaL_ref(lua_state, LUA_REGISTRYINDEX);
+
+	lua_pushcfunction(lua_state, ReportError);
+	report_ref = luaL_ref(lua_state, LUA_REGISTRYINDEX);
+}
+
+void LuaDispatch::RegisterActor(Actor* a) {
+	if (!per_type) {
+		return;
+	}
+	for (const auto& [key, slot] : a->components) {
+		Register(a->id, &a->component_pool[slot]);
+	}
+}
+
+void LuaDispatch::UnregisterActor(Actor* a) {
+	if (!per_type) {
+		return;
+	}
+	for (const auto& [key, slot] : a->components) {
+		Component* c = &a->component_pool[slot];
+		registrations.erase(c);
+		Remove(update_lists, c);
+		Remove(late_update_lists, c);
+	}
+}
+
+void LuaDispatch::RegisterComponent(Actor* a, Component& c) {
+	if (!per_type) {
+		return;
+	}
+	Register(a->id, &c);
+}
+
+void LuaDispatch::UnregisterComponent(Component& c) {
+	if (!per_type) {
+		return;
+	}
+	registrations.erase(&c);
+	Remove(update_lists, &c);
+	Remove(late_update_lists, &c);
+}
+
+void LuaDispatch::OnEnabledChanged(Component* c) {
+	if (!per_type) {
+		return;
+	}
+	auto itr = registrations.find(c);
+	if (itr == registrations.end()) {
+		return;
+	}
+	const Registration& r = itr->second;
+	if (c->isEnabled()) {
+		if (c->hasUpdate) {
+			Add(update_lists, r.actor_id, r.component, "OnUpdate");
+		}
+		if (c->hasLateUpdate) {
+			Add(late_update_lists, r.actor_id, r.component, "OnLateUpdate");
+		}
+	}
+	else {
+		Remove(update_lists, r.component);
+		Remove(late_update_lists, r.component);
+	}
+}
+
+void LuaDispatch::Update() {
+	Dispatch(update_lists);
+}
+
+void LuaDispatch::LateUpdate() {
+	Dispatch(late_update_lists);
+}
+
+// --- [ HELPER FUNCTIONS ] ---
+
+void LuaDispatch::Register(uint32_t actor_id, Component* c) {
+	// Native components are always dispatched per actor
+	if (!c->lifecycle || (!c->hasUpdate && !c->hasLateUpdate)) {
+		return;
+	}
+	registrations[c] = { actor_id, c };
+	if (!c->isEnabled()) {
+		return;
+	}
+	if (c->hasUpdate) {
+		Add(update_lists, actor_id, c, "OnUpdate");
+	}
+	if (c->hasLateUpdate) {
+		Add(late_update_lists, actor_id, c, "OnLateUpdate");
+	}
+}
+
+void LuaDispatch::Add(std::vector<TypeList>& lists, uint32_t actor_id, Component* c, const char* function_name) {
+	// Native components are always dispatched per actor
+	if (!c->lifecycle) {
+		return;
+	}
+	if (static_cast<int>(lists.size()) <= c->type_id) {
+		lists.resize(ComponentDB::GetTypeCount());
+	}
+	TypeList& list = lists[c->type_id];
+	lua_State* lua_state = ComponentManager::lua_state;
+	if (list.function_ref == LUA_NOREF) {
+		list.function_ref = ComponentManager::RefFunction(*ComponentDB::globalComponents[c->type].componentRef, function_name);
+		lua_newtable(lua_state);
+		list.instances_ref = luaL_ref(lua_state, LUA_REGISTRYINDEX);
+	}
+	if (list.positions.count(c) > 0) {
+		return;
+	}
+	if (dispatching) {
+		list.pending.push_back({ actor_id, c->key, c });
+		return;
+	}
+	Insert(list, { actor_id, c->key, c });
+}
+
+void LuaDispatch::Insert(TypeList& list, const Entry& entry) {
+	auto before = [](const Entry& a, const Entry& b) {
+		if (a.actor_id != b.actor_id) return a.actor_id < b.actor_id;
+		return a.key < b.key; };
+	// Actor ids only grow, so components of new actors go to the end without shifting anything
+	int size = static_cast<int>(list.entries.size());
+	int position = size;
+	if (size > 0 && !before(list.entries.back(), entry)) {
+		position = static_cast<int>(std::lower_bound(list.entries.begin(), list.entries.end(), entry, before) - list.entries.begin());
+	}
+	list.entries.insert(list.entries.begin() + position, entry);
+
+	lua_State* lua_state = ComponentManager::lua_state;
+	lua_rawgeti(lua_state, LUA_REGISTRYINDEX, list.instances_ref);
+	// Lua arrays are 1-indexed, shift the later instances up by one
+	for (int i = size; i > position; i--) {
+		lua_rawgeti(lua_state, -1, i);
+		lua_rawseti(lua_state, -2, static_cast<lua_Integer>(i) + 1);
+		if (list.entries[i].component != nullptr) {
+			list.positions[list.entries[i].component] = i;
+		}
+	}
+	entry.component->componentRef->push(lua_state);
+	lua_rawseti(lua_state, -2, static_cast<lua_Integer>(position) + 1);
+	lua_pop(lua_state, 1);
+	list.positions[entry.component] = position;
+}
+
+void LuaDispatch::Compact(TypeList& list) {
+	lua_State* lua_state = ComponentManager::lua_state;
+	lua_rawgeti(lua_state, LUA_REGISTRYINDEX, list.instances_ref);
+	int size = static_cast<int>(list.entries.size());
+	int live = 0;
+	for (int i = 0; i < size; i++) {
+		if (list.entries[i].component == nullptr) {
+			continue;
+		}
+		if (i != live) {
+			list.entries[live] = std::move(list.entries[i]);
+			list.positions[list.entries[live].component] = live;
+			lua_rawgeti(lua_state, -1, static_cast<lua_Integer>(i) + 1);
+			lua_rawseti(lua_state, -2, static_cast<lua_Integer>(live) + 1);
+		}
+		live++;
+	}
+	for (int i = live; i < size; i++) {
+		lua_pushnil(lua_state);
+		lua_rawseti(lua_state, -2, static_cast<lua_Integer>(i) + 1);
+	}
+	lua_pop(lua_state, 1);
+	list.entries.resize(live);
+	list.holes = 0;
+}
+
+void LuaDispatch::ApplyPending(std::vector<TypeList>& lists) {
+	for (TypeList& list : lists) {
+		for (const Entry& entry : list.pending) {
+			Insert(list, entry);
+		}
+		list.pending.clear();
+		if (list.holes * 2 > static_cast<int>(list.entries.size())) {
+			Compact(list);
+		}
+	}
+}
+
+void LuaDispatch::Remove(std::vector<TypeList>& lists, Component* c) {
+	if (c->type_id < 0 || c->type_id >= static_cast<int>(lists.size())) {
+		return;
+	}
+	TypeList& list = lists[c->type_id];
+	if (!list.pending.empty()) {
+		auto pending = std::find_if(list.pending.begin(), list.pending.end(), [&c](const Entry& e) {
+			return e.component == c; });
+		if (pending != list.pending.end()) {
+			list.pending.erase(pending);
+			return;
+		}
+	}
+	auto itr = list.positions.find(c);
+	if (itr == list.positions.end()) {
+		return;
+	}
+	int position = itr->second;
+	list.positions.erase(itr);
+	list.entries[position].component = nullptr;
+	list.holes++;
+
+	// Leave a hole instead of shifting the array, the driver skips it
+	lua_State* lua_state = ComponentManager::lua_state;
+	lua_rawgeti(lua_state, LUA_REGISTRYINDEX, list.instances_ref);
+	lua_pushboolean(lua_state, 0);
+	lua_rawseti(lua_state, -2, static_cast<lua_Integer>(position) + 1);
+	lua_pop(lua_state, 1);
+	if (!dispatching && list.holes * 2 > static_cast<int>(list.entries.size())) {
+		Compact(list);
+	}
+}
+
+void LuaDispatch::Dispatch(std::vector<TypeList>& lists) {
+	lua_State* lua_state = ComponentManager::lua_state;
+	int error_handler = ComponentManager::PushErrorHandler();
+	dispatching = true;
+	for (size_t type_id = 0; type_id < lists.size(); type_id++) {
+		TypeList& list = lists[type_id];
+		if (static_cast<int>(list.entries.size()) == list.holes || list.function_ref == LUA_NOREF) {
+			continue;
+		}
+
+		lua_rawgeti(lua_state, LUA_REGISTRYINDEX, driver_ref);
+		lua_rawgeti(lua_state, LUA_REGISTRYINDEX, list.instances_ref);
+		lua_rawgeti(lua_state, LUA_REGISTRYINDEX, list.function_ref);
+		lua_pushvalue(lua_state, error_handler);
+		lua_rawgeti(lua_state, LUA_REGISTRYINDEX, report_ref);
+		if (lua_pcall(lua_state, 4, 0, error_handler) != LUA_OK) {
+			EngineUtils::ReportError(ComponentDB::type_names[type_id], std::string(lua_tostring(lua_state, -1)));
+			lua_pop(lua_state, 1);
+		}
+	}
+	lua_settop(lua_state, error_handler - 1);
+	dispatching = false;
+
+	// Components enabled during the pass join both phases' lists now, as they would have between passes
+	ApplyPending(update_lists);
+	ApplyPending(late_update_lists);
+}
+
+int LuaDispatch::ReportError(lua_State* L) {
+	std::string actor_name = "";
+	lua_getfield(L, 1, "actor");
+	if (luabridge::Stack<ActorHandle>::isInstance(L, -1)) {
+		actor_name = luabridge::Stack<ActorHandle>::get(L, -1).GetName();
+	}
+	lua_pop(L, 1);
+	const char* message = lua_tostring(L, 2);
+	EngineUtils::ReportError(actor_name, std::string(message != nullptr ? message : ""));
+	return 0;
+}
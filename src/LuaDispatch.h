@@ -0,0 +1,115 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "lua.hpp"
+#include "LuaBridge/LuaBridge.h"
+#include "Component.h"
+
+class Actor;
+
+// Per-type dispatch of Lua OnUpdate/OnLateUpdate ("lua_dispatch": "per_type" in game.config).
+// Every component type keeps a Lua array of its live instances, and a small Lua driver
+// walks that array, so a phase costs one C++ -> Lua call per type instead of one per component.
+//
+// Ordering: types run in type name order, and within a type instances run in actor id order,
+// then component key order. Native components (Rigidbody, ParticleSystem, Tilemap) and OnStart
+// still run per actor, natives before any Lua type. Disabled components are taken out of the
+// lists and put back when enabled again.
+class LuaDispatch
+{
+public:
+	// True when lua_dispatch is "per_type", otherwise components are dispatched per actor
+	inline static bool per_type = false;
+
+	// Compiles the driver, call once the Lua state exists
+	static void Initialize();
+
+	// Adds every queued Lua component of an actor that just became part of the scene
+	static void RegisterActor(Actor* a);
+
+	// Removes every component of an actor that is about to be deleted
+	static void UnregisterActor(Actor* a);
+
+	// Adds a Lua component that was added to a live actor
+	static void RegisterComponent(Actor* a, Component& c);
+
+	// Removes a component from every type list
+	static void UnregisterComponent(Component& c);
+
+	// Adds or removes a registered component after Component::SetEnabled changed it
+	static void OnEnabledChanged(Component* c);
+
+	// Runs OnUpdate of every registered Lua component
+	static void Update();
+
+	// Runs OnLateUpdate of every registered Lua component
+	static void LateUpdate();
+
+private:
+	struct Entry {
+		uint32_t actor_id;
+		std::string key;
+		Component* component;
+	};
+
+	struct TypeList {
+		// In actor id, then component key order. Removed entries stay behind as holes (component
+		// nullptr) until half the list is holes, so removing never shifts or re-sorts the list.
+		std::vector<Entry> entries;
+		int holes = 0;
+
+		// Component -> index in entries, for removal without a search
+		std::unordered_map<Component*, int> positions;
+
+		// Entries added while the lists are being dispatched, inserted once the pass is done
+		std::vector<Entry> pending;
+
+		// Registry refs to the type's lifecycle function and the Lua array of instances. The array
+		// mirrors entries and is patched in place, holes are false.
+		int function_ref = LUA_NOREF;
+		int instances_ref = LUA_NOREF;
+	};
+
+	// Every registered Lua component, enabled or not, with the id of its actor
+	struct Registration {
+		uint32_t actor_id;
+		Component* component;
+	};
+	inline static std::unordered_map<Component*, Registration> registrations;
+
+	// Indexed by type ID, Lua type IDs follow type names so this is also the order types run in
+	inline static std::vector<TypeList> update_lists;
+	inline static std::vector<TypeList> late_update_lists;
+
+	// Set while the driver runs, the Lua arrays must not shift under it then
+	inline static bool dispatching = false;
+
+	inline static int driver_ref = LUA_NOREF;
+	inline static int report_ref = LUA_NOREF;
+
+	// Records a component and adds it to the lists of its phases if enabled
+	static void Register(uint32_t actor_id, Component* c);
+
+	// Adds a component to the list of its type for one phase
+	static void Add(std::vector<TypeList>& lists, uint32_t actor_id, Component* c, const char* function_name);
+
+	// Removes a component from every list of a phase
+	static void Remove(std::vector<TypeList>& lists, Component* c);
+
+	// Puts an entry at its place in entries and the Lua array
+	static void Insert(TypeList& list, const Entry& entry);
+
+	// Drops the holes from entries and the Lua array
+	static void Compact(TypeList& list);
+
+	// Inserts the entries added during a pass and compacts lists that are half holes
+	static void ApplyPending(std::vector<TypeList>& lists);
+
+	// Calls the driver once per type
+	static void Dispatch(std::vector<TypeList>& lists);
+
+	// Called by the driver as report(component, message) when a component errors
+	static int ReportError(lua_State* L);
+};
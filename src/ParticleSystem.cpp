@@ -1,6 +1,126 @@
 #include "ParticleSystem.h"
 #include "ImageDB.h"
 
+// --- JSON ---
+
+void ParticleSystem::ReadValues(const rapidjson::Value& value) {
+	if (value.HasMember("x")) {
+		x = value["x"].GetFloat();
+	}
+	if (value.HasMember("y")) {
+		y = value["y"].GetFloat();
+	}
+	if (value.HasMember("frames_between_bursts")) {
+		frames_between_bursts = value["frames_between_bursts"].GetInt();
+		// Ensure the frames between bursts is at least 1
+		if (frames_between_bursts < 1) {
+			frames_between_bursts = 1;
+		}
+	}
+	if (value.HasMember("burst_quantity")) {
+		burst_quantity = value["burst_quantity"].GetInt();
+		// Ensure the frames between bursts is at least 1
+		if (burst_quantity < 1) {
+			burst_quantity = 1;
+		}
+	}
+	if (value.HasMember("start_scale_min")) {
+		start_scale_min = value["start_scale_min"].GetFloat();
+	}
+	if (value.HasMember("start_scale_max")) {
+		start_scale_max = value["start_scale_max"].GetFloat();
+	}
+	if (value.HasMember("rotation_min")) {
+		rotation_min = value["rotation_min"].GetFloat();
+	}
+	if (value.HasMember("rotation_max")) {
+		rotation_max = value["rotation_max"].GetFloat();
+	}
+	if (value.HasMember("emit_radius_min")) {
+		emit_radius_min = value["emit_radius_min"].GetFloat();
+	}
+	if (value.HasMember("emit_radius_max")) {
+		emit_radius_max = value["emit_radius_max"].GetFloat();
+	}
+	if (value.HasMember("emit_angle_min")) {
+		emit_angle_min = value["emit_angle_min"].GetFloat();
+	}
+	if (value.HasMember("emit_angle_max")) {
+		emit_angle_max = value["emit_angle_max"].GetFloat();
+	}
+	
+	if (value.HasMember("start_color_r")) {
+		start_color_r = value["start_color_r"].GetInt();
+	}
+	if (value.HasMember("start_color_g")) {
+		start_color_g = value["start_color_g"].GetInt();
+	}
+	if (value.HasMember("start_color_b")) {
+		start_color_b = value["start_color_b"].GetInt();
+	}
+	if (value.HasMember("start_color_a")) {
+		start_color_a = value["start_color_a"].GetInt();
+	}
+	if (value.HasMember("end_color_r")) {
+		end_color_r = static_cast<int>(value["end_color_r"].GetFloat());
+		has_end_color = true;
+	}
+	if (value.HasMember("end_color_g")) {
+		end_color_g = static_cast<int>(value["end_color_g"].GetFloat());
+		has_end_color = true;
+	}
+	if (value.HasMember("end_color_b")) {
+		end_color_b = static_cast<int>(value["end_color_b"].GetFloat());
+		has_end_color = true;
+	}
+	if (value.HasMember("end_color_a")) {
+		end_color_a = static_cast<int>(value["end_color_a"].GetFloat());
+		has_end_color = true;
+	}
+
+	if (value.HasMember("image")) {
+		image = value["image"].GetString();
+	}
+
+	if (value.HasMember("duration_frames")) {
+		duration_frames = value["duration_frames"].GetInt();
+		if (duration_frames < 1) {
+			duration_frames = 1;
+		}
+	}
+	if (value.HasMember("start_speed_min")) {
+		start_speed_min = value["start_speed_min"].GetFloat();
+	}
+	if (value.HasMember("start_speed_max")) {
+		start_speed_max = value["start_speed_max"].GetFloat();
+	}
+	if (value.HasMember("rotation_speed_min")) {
+		rotation_speed_min = value["rotation_speed_min"].GetFloat();
+	}
+	if (value.HasMember("rotation_speed_max")) {
+		rotation_speed_max = value["rotation_speed_max"].GetFloat();
+	}
+	if (value.HasMember("gravity_scale_x")) {
+		gravity_scale_x = value["gravity_scale_x"].GetFloat();
+	}
+	if (value.HasMember("gravity_scale_y")) {
+		gravity_scale_y = value["gravity_scale_y"].GetFloat();
+	}
+	if (value.HasMember("drag_factor")) {
+		drag_factor = value["drag_factor"].GetFloat();
+	}
+	if (value.HasMember("angular_drag_factor")) {
+		angular_drag_factor = value["angular_drag_factor"].GetFloat();
+	}
+	if (value.HasMember("end_scale")) {
+		end_scale = value["end_scale"].GetFloat();
+		has_end_scale = true;
+	}
+	if (value.HasMember("sorting_order")) {
+		sorting_order = value["sorting_order"].GetInt();
+	}
+}
+
 // --- LIFECYCLE FUNCTIONS ---
 
 void ParticleSystem::OnStart() {
@@ -104,6 +224,8 @@ void ParticleSystem::ProcessParticle(int index) {
 }
 
 void ParticleSystem::Render() {
+	// Hidden particles still age and move, so showing the actor again resumes mid-effect
+	bool hidden = Renderer::IsHidden(actor);
 	int num_particles = is_active.size();
 	for (int i = 0; i < num_particles; i++) {
 		// Process and render every particle
@@ -116,6 +238,9 @@ void ParticleSystem::Render() {
 			continue;
 		}
 		ProcessParticle(i);
+		if (hidden) {
+			continue;
+		}
 		Renderer::DrawEx(image, x_values[i], y_values[i], rotation_values[i], scale_values[i], scale_values[i], 0.5f, 0.5f, color_values[i].r, color_values[i].g, color_values[i].b, color_values[i].a, sorting_order);
 	}
 }
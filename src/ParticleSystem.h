@@ -45,7 +45,7 @@ public:
 	std::string key = "???";
 	std::string type = "Rigidbody";
 
-	const std::string DEFAULT_PARTICLE_NAME = "default_particle";
+	inline static const std::string DEFAULT_PARTICLE_NAME = "default_particle";
 
 	// Initial ParticleSystem variables
 	float x = 0.0f;
@@ -130,6 +130,9 @@ public:
 	std::vector<float> angular_vel_values;
 
 
+	// Sets the variables present in a component's json, leaving the rest as they are
+	void ReadValues(const rapidjson::Value& value);
+
 	// --- [ LIFE CYCLE FUNCTIONS ] ---
 
 	// Runs on component creation
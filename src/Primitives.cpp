@@ -0,0 +1,298 @@
+#include "Primitives.h"
+#include "Renderer.h"
+#include "World.h"
+#include "RenderStats.h"
+#include <algorithm>
+#include <cmath>
+
+// --- [ PRIMITIVE BATCH ] ---
+
+void PrimitiveBatch::Clear() {
+	vertices.clear();
+	indices.clear();
+}
+
+void PrimitiveBatch::AddLine(float x0, float y0, float x1, float y1, float thickness, SDL_Color color) {
+	float dx = x1 - x0;
+	float dy = y1 - y0;
+	float length = std::sqrt(dx * dx + dy * dy);
+	if (length <= 0.0f) {
+		// Degenerate lines still show up as a dot
+		dx = 1.0f;
+		dy = 0.0f;
+		length = 1.0f;
+	}
+	// Offset both ends by half the thickness along the normal
+	float nx = -dy / length * thickness * 0.5f;
+	float ny = dx / length * thickness * 0.5f;
+
+	int base = static_cast<int>(vertices.size());
+	vertices.push_back({ { x0 + nx, y0 + ny }, color, { 0.0f, 0.0f } });
+	vertices.push_back({ { x1 + nx, y1 + ny }, color, { 0.0f, 0.0f } });
+	vertices.push_back({ { x1 - nx, y1 - ny }, color, { 0.0f, 0.0f } });
+	vertices.push_back({ { x0 - nx, y0 - ny }, color, { 0.0f, 0.0f } });
+	indices.insert(indices.end(), { base, base + 1, base + 2, base + 2, base + 3, base });
+}
+
+void PrimitiveBatch::AddPolygon(const SDL_FPoint* points, int count, float thickness, SDL_Color color, bool filled) {
+	if (count < 2) {
+		return;
+	}
+	if (!filled) {
+		for (int i = 0; i < count; i++) {
+			const SDL_FPoint& a = points[i];
+			const SDL_FPoint& b = points[(i + 1) % count];
+			AddLine(a.x, a.y, b.x, b.y, thickness, color);
+		}
+		return;
+	}
+	// Triangle fan around the first point
+	int base = static_cast<int>(vertices.size());
+	for (int i = 0; i < count; i++) {
+		vertices.push_back({ points[i], color, { 0.0f, 0.0f } });
+	}
+	for (int i = 1; i + 1 < count; i++) {
+		indices.insert(indices.end(), { base, base + i, base + i + 1 });
+	}
+}
+
+void PrimitiveBatch::AddCircle(float x, float y, float radius, int segments, float thickness, SDL_Color color, bool filled) {
+	int base = static_cast<int>(vertices.size());
+	float step = 2.0f * b2_pi / segments;
+	if (filled) {
+		vertices.push_back({ { x, y }, color, { 0.0f, 0.0f } });
+		for (int i = 0; i < segments; i++) {
+			float angle = i * step;
+			vertices.push_back({ { x + std::cos(angle) * radius, y + std::sin(angle) * radius }, color, { 0.0f, 0.0f } });
+		}
+		for (int i = 0; i < segments; i++) {
+			indices.insert(indices.end(), { base, base + 1 + i, base + 1 + (i + 1) % segments });
+		}
+		return;
+	}
+	// Outline as a ring with an inner and outer vertex per segment
+	float inner = std::max(0.0f, radius - thickness * 0.5f);
+	float outer = radius + thickness * 0.5f;
+	for (int i = 0; i < segments; i++) {
+		float angle = i * step;
+		float c = std::cos(angle);
+		float s = std::sin(angle);
+		vertices.push_back({ { x + c * inner, y + s * inner }, color, { 0.0f, 0.0f } });
+		vertices.push_back({ { x + c * outer, y + s * outer }, color, { 0.0f, 0.0f } });
+	}
+	for (int i = 0; i < segments; i++) {
+		int cur = base + i * 2;
+		int next = base + ((i + 1) % segments) * 2;
+		indices.insert(indices.end(), { cur, cur + 1, next + 1, next + 1, next, cur });
+	}
+}
+
+// --- [ PHYSICS DEBUG DRAW ] ---
+
+SDL_Color PhysicsDebugDraw::ToSDLColor(const b2Color& color, float alpha_scale) {
+	return {
+		static_cast<Uint8>(std::clamp(color.r, 0.0f, 1.0f) * 255.0f),
+		static_cast<Uint8>(std::clamp(color.g, 0.0f, 1.0f) * 255.0f),
+		static_cast<Uint8>(std::clamp(color.b, 0.0f, 1.0f) * 255.0f),
+		static_cast<Uint8>(std::clamp(color.a * alpha_scale, 0.0f, 1.0f) * 255.0f)
+	};
+}
+
+void PhysicsDebugDraw::DrawPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color) {
+	std::vector<SDL_FPoint> points(vertexCount);
+	for (int32 i = 0; i < vertexCount; i++) {
+		points[i] = { vertices[i].x * Primitives::pixels_per_meter, vertices[i].y * Primitives::pixels_per_meter };
+	}
+	Primitives::world_batch.AddPolygon(points.data(), vertexCount, 1.0f / Renderer::zoom_factor, PhysicsDebugDraw::ToSDLColor(color, 1.0f), false);
+}
+
+void PhysicsDebugDraw::DrawSolidPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color) {
+	std::vector<SDL_FPoint> points(vertexCount);
+	for (int32 i = 0; i < vertexCount; i++) {
+		points[i] = { vertices[i].x * Primitives::pixels_per_meter, vertices[i].y * Primitives::pixels_per_meter };
+	}
+	float thickness = 1.0f / Renderer::zoom_factor;
+	Primitives::world_batch.AddPolygon(points.data(), vertexCount, thickness, PhysicsDebugDraw::ToSDLColor(color, 0.5f), true);
+	Primitives::world_batch.AddPolygon(points.data(), vertexCount, thickness, PhysicsDebugDraw::ToSDLColor(color, 1.0f), false);
+}
+
+void PhysicsDebugDraw::DrawCircle(const b2Vec2& center, float radius, const b2Color& color) {
+	float r = radius * Primitives::pixels_per_meter;
+	Primitives::world_batch.AddCircle(center.x * Primitives::pixels_per_meter, center.y * Primitives::pixels_per_meter, r, 24, 1.0f / Renderer::zoom_factor, PhysicsDebugDraw::ToSDLColor(color, 1.0f), false);
+}
+
+void PhysicsDebugDraw::DrawSolidCircle(const b2Vec2& center, float radius, const b2Vec2& axis, const b2Color& color) {
+	float x = center.x * Primitives::pixels_per_meter;
+	float y = center.y * Primitives::pixels_per_meter;
+	float r = radius * Primitives::pixels_per_meter;
+	float thickness = 1.0f / Renderer::zoom_factor;
+	Primitives::world_batch.AddCircle(x, y, r, 24, thickness, PhysicsDebugDraw::ToSDLColor(color, 0.5f), true);
+	Primitives::world_batch.AddCircle(x, y, r, 24, thickness, PhysicsDebugDraw::ToSDLColor(color, 1.0f), false);
+	// Show the body's rotation
+	Primitives::world_batch.AddLine(x, y, x + axis.x * r, y + axis.y * r, thickness, PhysicsDebugDraw::ToSDLColor(color, 1.0f));
+}
+
+void PhysicsDebugDraw::DrawSegment(const b2Vec2& p1, const b2Vec2& p2, const b2Color& color) {
+	Primitives::world_batch.AddLine(p1.x * Primitives::pixels_per_meter, p1.y * Primitives::pixels_per_meter, p2.x * Primitives::pixels_per_meter, p2.y * Primitives::pixels_per_meter, 1.0f / Renderer::zoom_factor, PhysicsDebugDraw::ToSDLColor(color, 1.0f));
+}
+
+void PhysicsDebugDraw::DrawTransform(const b2Transform& xf) {
+	const float axis_length = 0.4f;
+	b2Vec2 p = xf.p;
+	b2Vec2 x_axis = p + axis_length * xf.q.GetXAxis();
+	b2Vec2 y_axis = p + axis_length * xf.q.GetYAxis();
+	DrawSegment(p, x_axis, b2Color(1.0f, 0.0f, 0.0f));
+	DrawSegment(p, y_axis, b2Color(0.0f, 1.0f, 0.0f));
+}
+
+void PhysicsDebugDraw::DrawPoint(const b2Vec2& p, float size, const b2Color& color) {
+	// size is in screen pixels
+	float half = size * 0.5f / Renderer::zoom_factor;
+	float x = p.x * Primitives::pixels_per_meter;
+	float y = p.y * Primitives::pixels_per_meter;
+	SDL_FPoint corners[4] = { { x - half, y - half }, { x + half, y - half }, { x + half, y + half }, { x - half, y + half } };
+	Primitives::world_batch.AddPolygon(corners, 4, 0.0f, PhysicsDebugDraw::ToSDLColor(color, 1.0f), true);
+}
+
+// --- [ FLUSHING ] ---
+
+void Primitives::FlushWorld() {
+	if (physics_debug_draw_enabled) {
+		DrawPhysicsWorld();
+	}
+	if (world_batch.indices.empty()) {
+		world_batch.Clear();
+		return;
+	}
+	float zoom_factor = Renderer::zoom_factor;
+	glm::ivec2 cam_dimensions = Renderer::window_size;
+
+	// Same placement as images
+	float offset_x = -Renderer::current_cam_pos.x * pixels_per_meter + cam_dimensions.x * 0.5f * (1.0f / zoom_factor);
+	float offset_y = -Renderer::current_cam_pos.y * pixels_per_meter + cam_dimensions.y * 0.5f * (1.0f / zoom_factor);
+
+	scratch.resize(world_batch.vertices.size());
+	for (size_t i = 0; i < world_batch.vertices.size(); i++) {
+		scratch[i] = world_batch.vertices[i];
+		scratch[i].position.x += offset_x;
+		scratch[i].position.y += offset_y;
+	}
+	SDL_SetRenderDrawBlendMode(Renderer::renderer, SDL_BLENDMODE_BLEND);
+	SDL_RenderGeometry(Renderer::renderer, nullptr, scratch.data(), static_cast<int>(scratch.size()), world_batch.indices.data(), static_cast<int>(world_batch.indices.size()));
+	RenderStats::RecordDraw(nullptr, { 255, 255, 255, 255 });
+	SDL_SetRenderDrawBlendMode(Renderer::renderer, SDL_BLENDMODE_NONE);
+	world_batch.Clear();
+}
+
+void Primitives::FlushUI() {
+	if (!ui_batch.indices.empty()) {
+		SDL_SetRenderDrawBlendMode(Renderer::renderer, SDL_BLENDMODE_BLEND);
+		SDL_RenderGeometry(Renderer::renderer, nullptr, ui_batch.vertices.data(), static_cast<int>(ui_batch.vertices.size()), ui_batch.indices.data(), static_cast<int>(ui_batch.indices.size()));
+		RenderStats::RecordDraw(nullptr, { 255, 255, 255, 255 });
+		SDL_SetRenderDrawBlendMode(Renderer::renderer, SDL_BLENDMODE_NONE);
+	}
+	ui_batch.Clear();
+}
+
+void Primitives::DrawPhysicsWorld() {
+	if (!World::Exists()) {
+		return;
+	}
+	physics_debug_draw.SetFlags(b2Draw::e_shapeBit | b2Draw::e_jointBit | b2Draw::e_aabbBit | b2Draw::e_centerOfMassBit);
+	World::world->SetDebugDraw(&physics_debug_draw);
+	World::world->DebugDraw();
+
+	// Contact points and normals of every touching contact
+	const b2Color contact_color(1.0f, 1.0f, 0.0f);
+	for (b2Contact* contact = World::world->GetContactList(); contact != nullptr; contact = contact->GetNext()) {
+		if (!contact->IsTouching()) {
+			continue;
+		}
+		b2WorldManifold world_manifold;
+		contact->GetWorldManifold(&world_manifold);
+		int32 point_count = contact->GetManifold()->pointCount;
+		for (int32 i = 0; i < point_count; i++) {
+			const b2Vec2& point = world_manifold.points[i];
+			physics_debug_draw.DrawPoint(point, 4.0f, contact_color);
+			physics_debug_draw.DrawSegment(point, point + 0.2f * world_manifold.normal, contact_color);
+		}
+	}
+}
+
+// --- [ LUA DRAW FUNCTIONS ] ---
+
+void Primitives::Line(float x0, float y0, float x1, float y1, float r, float g, float b, float a) {
+	world_batch.AddLine(x0 * pixels_per_meter, y0 * pixels_per_meter, x1 * pixels_per_meter, y1 * pixels_per_meter, WorldLineThickness(), MakeColor(r, g, b, a));
+}
+
+void Primitives::Rect(float x, float y, float w, float h, float r, float g, float b, float a, bool filled) {
+	float x0 = x * pixels_per_meter;
+	float y0 = y * pixels_per_meter;
+	float x1 = (x + w) * pixels_per_meter;
+	float y1 = (y + h) * pixels_per_meter;
+	SDL_FPoint corners[4] = { { x0, y0 }, { x1, y0 }, { x1, y1 }, { x0, y1 } };
+	world_batch.AddPolygon(corners, 4, WorldLineThickness(), MakeColor(r, g, b, a), filled);
+}
+
+void Primitives::Circle(float x, float y, float radius, float r, float g, float b, float a, bool filled) {
+	float radius_px = radius * pixels_per_meter;
+	world_batch.AddCircle(x * pixels_per_meter, y * pixels_per_meter, radius_px, CircleSegments(radius_px * Renderer::zoom_factor), WorldLineThickness(), MakeColor(r, g, b, a), filled);
+}
+
+void Primitives::Polygon(luabridge::LuaRef points, float r, float g, float b, float a, bool filled) {
+	ReadPoints(points, pixels_per_meter);
+	world_batch.AddPolygon(points_scratch.data(), static_cast<int>(points_scratch.size()), WorldLineThickness(), MakeColor(r, g, b, a), filled);
+}
+
+void Primitives::LineUI(float x0, float y0, float x1, float y1, float r, float g, float b, float a) {
+	ui_batch.AddLine(x0, y0, x1, y1, 1.0f, MakeColor(r, g, b, a));
+}
+
+void Primitives::RectUI(float x, float y, float w, float h, float r, float g, float b, float a, bool filled) {
+	SDL_FPoint corners[4] = { { x, y }, { x + w, y }, { x + w, y + h }, { x, y + h } };
+	ui_batch.AddPolygon(corners, 4, 1.0f, MakeColor(r, g, b, a), filled);
+}
+
+void Primitives::CircleUI(float x, float y, float radius, float r, float g, float b, float a, bool filled) {
+	ui_batch.AddCircle(x, y, radius, CircleSegments(radius), 1.0f, MakeColor(r, g, b, a), filled);
+}
+
+void Primitives::PolygonUI(luabridge::LuaRef points, float r, float g, float b, float a, bool filled) {
+	ReadPoints(points, 1.0f);
+	ui_batch.AddPolygon(points_scratch.data(), static_cast<int>(points_scratch.size()), 1.0f, MakeColor(r, g, b, a), filled);
+}
+
+void Primitives::SetPhysicsDebugDraw(bool enabled) {
+	physics_debug_draw_enabled = enabled;
+}
+
+// --- [ HELPER FUNCTIONS ] ---
+
+float Primitives::WorldLineThickness() {
+	return 1.0f / Renderer::zoom_factor;
+}
+
+int Primitives::CircleSegments(float radius) {
+	return std::clamp(static_cast<int>(radius * 0.5f), 12, 64);
+}
+
+void Primitives::ReadPoints(luabridge::LuaRef points, float scale) {
+	points_scratch.clear();
+	if (!points.isTable()) {
+		return;
+	}
+	int count = points.length();
+	for (int i = 1; i <= count; i++) {
+		b2Vec2 point = points[i].cast<b2Vec2>();
+		points_scratch.push_back({ point.x * scale, point.y * scale });
+	}
+}
+
+SDL_Color Primitives::MakeColor(float r, float g, float b, float a) {
+	return {
+		static_cast<Uint8>(std::clamp(static_cast<int>(r), 0, 255)),
+		static_cast<Uint8>(std::clamp(static_cast<int>(g), 0, 255)),
+		static_cast<Uint8>(std::clamp(static_cast<int>(b), 0, 255)),
+		static_cast<Uint8>(std::clamp(static_cast<int>(a), 0, 255))
+	};
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <vector>
+#include "SDL2/SDL.h"
+#include "box2d/box2d.h"
+#include "lua.hpp"
+#include "LuaBridge/LuaBridge.h"
+
+// Untextured triangles accumulated over a frame and drawn with a single SDL_RenderGeometry call.
+struct PrimitiveBatch {
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> indices;
+
+	void Clear();
+
+	// A quad for a line [thickness] wide from (x0, y0) to (x1, y1)
+	void AddLine(float x0, float y0, float x1, float y1, float thickness, SDL_Color color);
+
+	// A convex polygon, filled as a triangle fan or outlined with lines
+	void AddPolygon(const SDL_FPoint* points, int count, float thickness, SDL_Color color, bool filled);
+
+	// A circle approximated by [segments] sides
+	void AddCircle(float x, float y, float radius, int segments, float thickness, SDL_Color color, bool filled);
+};
+
+// Draws every Box2D collider, AABB and center of mass into the scene primitive batch
+class PhysicsDebugDraw : public b2Draw {
+public:
+	void DrawPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color) override;
+	void DrawSolidPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color) override;
+	void DrawCircle(const b2Vec2& center, float radius, const b2Color& color) override;
+	void DrawSolidCircle(const b2Vec2& center, float radius, const b2Vec2& axis, const b2Color& color) override;
+	void DrawSegment(const b2Vec2& p1, const b2Vec2& p2, const b2Color& color) override;
+	void DrawTransform(const b2Transform& xf) override;
+	void DrawPoint(const b2Vec2& p, float size, const b2Color& color) override;
+
+private:
+	static SDL_Color ToSDLColor(const b2Color& color, float alpha_scale);
+};
+
+class Primitives
+{
+public:
+	// Draws the scene batch offset by the camera, call while the zoom scale is applied
+	static void FlushWorld();
+
+	// Draws the UI batch in screen coordinates
+	static void FlushUI();
+
+	// --- [ LUA DRAW FUNCTIONS ] ----
+
+	// Draws a line via scene coordinates (affected by cam, zoom)
+	static void Line(float x0, float y0, float x1, float y1, float r, float g, float b, float a);
+
+	// Draws a rectangle with its top left corner at (x, y) via scene coordinates
+	static void Rect(float x, float y, float w, float h, float r, float g, float b, float a, bool filled);
+
+	// Draws a circle via scene coordinates
+	static void Circle(float x, float y, float radius, float r, float g, float b, float a, bool filled);
+
+	// Draws a convex polygon from an array of Vector2 via scene coordinates
+	static void Polygon(luabridge::LuaRef points, float r, float g, float b, float a, bool filled);
+
+	// Draws a line via screen coordinates
+	static void LineUI(float x0, float y0, float x1, float y1, float r, float g, float b, float a);
+
+	// Draws a rectangle with its top left corner at (x, y) via screen coordinates
+	static void RectUI(float x, float y, float w, float h, float r, float g, float b, float a, bool filled);
+
+	// Draws a circle via screen coordinates
+	static void CircleUI(float x, float y, float radius, float r, float g, float b, float a, bool filled);
+
+	// Draws a convex polygon from an array of Vector2 via screen coordinates
+	static void PolygonUI(luabridge::LuaRef points, float r, float g, float b, float a, bool filled);
+
+	// Enables drawing the Box2D world every frame
+	static void SetPhysicsDebugDraw(bool enabled);
+
+	inline static const float pixels_per_meter = 100.0f;
+
+	// ---- [ BATCHES ] ----
+
+	// Scene batch, in pixels of scene space (meters * 100), offset by the camera on flush
+	inline static PrimitiveBatch world_batch;
+
+	// Screen space batch drawn after UI
+	inline static PrimitiveBatch ui_batch;
+
+	inline static PhysicsDebugDraw physics_debug_draw;
+	inline static bool physics_debug_draw_enabled = false;
+
+	// Submits the Box2D world and its touching contacts to the scene batch
+	static void DrawPhysicsWorld();
+
+private:
+	inline static std::vector<SDL_Vertex> scratch;
+	inline static std::vector<SDL_FPoint> points_scratch;
+
+	// Scene lines stay one screen pixel wide regardless of zoom
+	static float WorldLineThickness();
+
+	// Number of sides for a circle of [radius] pixels
+	static int CircleSegments(float radius);
+
+	// Reads an array of Vector2 into points_scratch, scaled by [scale]
+	static void ReadPoints(luabridge::LuaRef points, float scale);
+
+	static SDL_Color MakeColor(float r, float g, float b, float a);
+};
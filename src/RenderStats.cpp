@@ -0,0 +1,166 @@
+#include "RenderStats.h"
+#include "Renderer.h"
+#include "TextDB.h"
+#include "Helper.h"
+#include <cstdio>
+#include <iostream>
+
+static const char* pass_names[RenderStats::PASS_COUNT] = { "image", "ui", "text", "pixel" };
+
+void RenderStats::BeginPass(Pass pass) {
+	current_pass = pass;
+	has_last_draw = false;
+	last_texture = nullptr;
+}
+
+void RenderStats::RecordDraw(SDL_Texture* texture, SDL_Color tint) {
+	PassStats& stats = current[current_pass];
+	stats.draw_calls++;
+	bool same_texture = has_last_draw && texture == last_texture;
+	bool same_tint = has_last_draw && tint.r == last_tint.r && tint.g == last_tint.g && tint.b == last_tint.b && tint.a == last_tint.a;
+	if (has_last_draw && !same_texture) {
+		stats.texture_switches++;
+	}
+	if (!same_texture || !same_tint) {
+		stats.batches++;
+	}
+	last_texture = texture;
+	last_tint = tint;
+	has_last_draw = true;
+}
+
+void RenderStats::RecordSubmitted(int count) {
+	current[current_pass].submitted += count;
+}
+
+void RenderStats::RecordCulled(int count) {
+	current[current_pass].culled += count;
+}
+
+void RenderStats::RecordModChanges(int count) {
+	current[current_pass].mod_changes += count;
+}
+
+void RenderStats::RecordTextRasterization() {
+	current[current_pass].text_rasterizations++;
+}
+
+void RenderStats::DrawOverlay() {
+	if (!overlay_enabled) {
+		return;
+	}
+	if (overlay_font.empty()) {
+		std::cout << "error: stats overlay requires stats_overlay_font in rendering.config";
+		exit(0);
+	}
+	if (TextDB::fonts.count(overlay_font) == 0 || TextDB::fonts[overlay_font].count(overlay_font_size) == 0) {
+		TextDB::LoadFont(overlay_font, overlay_font_size);
+	}
+	TTF_Font* font = TextDB::fonts[overlay_font][overlay_font_size];
+
+	// Shows the last finished frame, the current one is still being counted
+	char line[128];
+	std::string lines[PASS_COUNT + 1];
+	std::snprintf(line, sizeof(line), "%-6s %5s %5s %5s %5s %5s %5s %5s", "pass", "sub", "cull", "batch", "calls", "tex", "mods", "text");
+	lines[0] = line;
+	for (int i = 0; i < PASS_COUNT; i++) {
+		const PassStats& s = last[i];
+		std::snprintf(line, sizeof(line), "%-6s %5d %5d %5d %5d %5d %5d %5d", pass_names[i], s.submitted, s.culled, s.batches, s.draw_calls, s.texture_switches, s.mod_changes, s.text_rasterizations);
+		lines[i + 1] = line;
+	}
+
+	int line_height = TTF_FontLineSkip(font);
+	SDL_Rect background = { 0, 0, 0, line_height * (PASS_COUNT + 1) + 8 };
+	int width = 0;
+	TTF_SizeText(font, lines[0].c_str(), &width, nullptr);
+	background.w = width + 8;
+
+	SDL_SetRenderDrawBlendMode(Renderer::renderer, SDL_BLENDMODE_BLEND);
+	SDL_SetRenderDrawColor(Renderer::renderer, 0, 0, 0, 160);
+	SDL_RenderFillRect(Renderer::renderer, &background);
+	SDL_SetRenderDrawBlendMode(Renderer::renderer, SDL_BLENDMODE_NONE);
+
+	for (int i = 0; i < PASS_COUNT + 1; i++) {
+		SDL_Surface* surface = TTF_RenderText_Blended(font, lines[i].c_str(), { 255, 255, 255, 255 });
+		if (surface == nullptr) {
+			continue;
+		}
+		SDL_Texture* texture = SDL_CreateTextureFromSurface(Renderer::renderer, surface);
+		SDL_FRect dst = { 4.0f, static_cast<float>(4 + i * line_height), static_cast<float>(surface->w), static_cast<float>(surface->h) };
+		Helper::SDL_RenderCopy(Renderer::renderer, texture, nullptr, &dst);
+		SDL_DestroyTexture(texture);
+		SDL_FreeSurface(surface);
+	}
+}
+
+void RenderStats::EndFrame() {
+	if (csv_file.is_open()) {
+		for (int i = 0; i < PASS_COUNT; i++) {
+			const PassStats& s = current[i];
+			csv_file << frame << "," << pass_names[i] << "," << s.submitted << "," << s.culled << "," << s.batches << ","
+				<< s.draw_calls << "," << s.texture_switches << "," << s.mod_changes << "," << s.text_rasterizations << "\n";
+		}
+	}
+	for (int i = 0; i < PASS_COUNT; i++) {
+		last[i] = current[i];
+		current[i] = PassStats();
+	}
+	frame++;
+}
+
+void RenderStats::OpenCSV(const std::string& file_name) {
+	csv_file.open("resources/" + file_name, std::ios::out | std::ios::trunc);
+	if (!csv_file.is_open()) {
+		std::cout << "error: could not open stats csv " << file_name;
+		exit(0);
+	}
+	csv_file << "frame,pass,submitted,culled,batches,draw_calls,texture_switches,mod_changes,text_rasterizations\n";
+}
+
+// --- [ LUA FUNCTIONS ] ---
+
+int RenderStats::Get(std::string pass, std::string stat) {
+	int index = GetPassIndex(pass);
+	if (index == PASS_COUNT) {
+		return 0;
+	}
+	int* value = GetStat(last[index], stat);
+	return value == nullptr ? 0 : *value;
+}
+
+int RenderStats::GetTotal(std::string stat) {
+	int total = 0;
+	for (int i = 0; i < PASS_COUNT; i++) {
+		int* value = GetStat(last[i], stat);
+		if (value != nullptr) {
+			total += *value;
+		}
+	}
+	return total;
+}
+
+void RenderStats::SetOverlay(bool enabled) {
+	overlay_enabled = enabled;
+}
+
+// --- [ HELPER FUNCTIONS ] ---
+
+int* RenderStats::GetStat(PassStats& stats, const std::string& stat) {
+	if (stat == "submitted") return &stats.submitted;
+	if (stat == "culled") return &stats.culled;
+	if (stat == "batches") return &stats.batches;
+	if (stat == "draw_calls") return &stats.draw_calls;
+	if (stat == "texture_switches") return &stats.texture_switches;
+	if (stat == "mod_changes") return &stats.mod_changes;
+	if (stat == "text_rasterizations") return &stats.text_rasterizations;
+	return nullptr;
+}
+
+int RenderStats::GetPassIndex(const std::string& pass) {
+	for (int i = 0; i < PASS_COUNT; i++) {
+		if (pass == pass_names[i]) {
+			return i;
+		}
+	}
+	return PASS_COUNT;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <string>
+#include <fstream>
+#include "SDL2/SDL.h"
+#include "SDL2_ttf/SDL_ttf.h"
+
+// Counters of a single render pass over one frame.
+struct PassStats {
+	int submitted = 0; // requests queued for the pass
+	int culled = 0; // requests dropped before drawing
+	int batches = 0; // runs of consecutive draws sharing a texture and tint
+	int draw_calls = 0; // SDL_RenderCopy* and SDL_RenderGeometry calls
+	int texture_switches = 0; // draw calls using a different texture than the previous one
+	int mod_changes = 0; // texture color/alpha mod calls
+	int text_rasterizations = 0; // strings rendered to a surface by SDL_ttf
+};
+
+class RenderStats
+{
+public:
+	enum Pass { IMAGE, UI, TEXT, PIXEL, PASS_COUNT };
+
+	// Counters are attributed to this pass until the next BeginPass
+	static void BeginPass(Pass pass);
+
+	// Records a draw call, counting texture switches and batches against the previous draw of the pass
+	static void RecordDraw(SDL_Texture* texture, SDL_Color tint);
+
+	static void RecordSubmitted(int count);
+	static void RecordCulled(int count);
+	static void RecordModChanges(int count);
+	static void RecordTextRasterization();
+
+	// Draws the stats overlay over everything else if enabled
+	static void DrawOverlay();
+
+	// Publishes this frame's counters, writes the CSV row and resets for the next frame
+	static void EndFrame();
+
+	// Opens resources/[file_name] and writes the CSV header
+	static void OpenCSV(const std::string& file_name);
+
+	// --- [ LUA FUNCTIONS ] ---
+
+	// Returns [stat] of [pass] ("image", "ui", "text" or "pixel") for the last frame
+	static int Get(std::string pass, std::string stat);
+
+	// Returns [stat] summed over every pass for the last frame
+	static int GetTotal(std::string stat);
+
+	// Shows or hides the overlay, requires stats_overlay_font in rendering.config
+	static void SetOverlay(bool enabled);
+
+	// ---- [ CONFIG ] ----
+
+	inline static bool overlay_enabled = false;
+	inline static std::string overlay_font = "";
+	inline static int overlay_font_size = 14;
+
+private:
+	inline static PassStats current[PASS_COUNT];
+	inline static PassStats last[PASS_COUNT];
+
+	inline static Pass current_pass = IMAGE;
+
+	// Previous draw of the current pass, used to detect texture switches and batch breaks
+	inline static SDL_Texture* last_texture = nullptr;
+	inline static SDL_Color last_tint = { 255, 255, 255, 255 };
+	inline static bool has_last_draw = false;
+
+	inline static int frame = 0;
+	inline static std::ofstream csv_file;
+
+	// Returns a pointer to the named counter of [stats], or nullptr for unknown names
+	static int* GetStat(PassStats& stats, const std::string& stat);
+
+	// Returns the pass index for a name, or PASS_COUNT if unknown
+	static int GetPassIndex(const std::string& pass);
+};
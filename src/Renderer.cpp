@@ -2,6 +2,10 @@
 #include "Helper.h"
 #include "Actor.h"
 #include "ImageDB.h"
+#include "Canvas.h"
+#include "Primitives.h"
+#include "RenderStats.h"
+#include "TagDB.h"
 
 
 ImageDrawRequest::ImageDrawRequest(std::string _img, float _x, float _y) :
@@ -20,6 +24,7 @@ ImageDrawRequest::ImageDrawRequest(std::string _img, float _x, float _y) :
 	sorting_order(0)
 {
 	tex = ImageDB::GetImage(_img);
+	tex_id = ImageDB::GetImageID(tex);
 	SDL_FRect tex_rect;
 	Helper::SDL_QueryTexture(tex, &tex_rect.w, &tex_rect.h);
 	width = tex_rect.w;
@@ -44,18 +49,46 @@ ImageDrawRequest::ImageDrawRequest(std::string _img, float _x, float _y, float _
 	sorting_order(_sorting_order)
 {
 	tex = ImageDB::GetImage(_img);
+	tex_id = ImageDB::GetImageID(tex);
 	SDL_FRect tex_rect;
 	Helper::SDL_QueryTexture(tex, &tex_rect.w, &tex_rect.h);
 	width = tex_rect.w;
 	height = tex_rect.h;
 }
 
+// Packs a tint into one integer so draws can be grouped by it
+static uint32_t PackTint(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+	return (static_cast<uint32_t>(r) << 24) | (static_cast<uint32_t>(g) << 16) | (static_cast<uint32_t>(b) << 8) | a;
+}
+
 void Renderer::makeWindow() {
+	if (backend == "software") {
+		// Headless: only events are needed, so machines without a display or GPU can run the game
+		SDL_InitSubSystem(SDL_INIT_EVENTS);
+		return;
+	}
 	window = Helper::SDL_CreateWindow(game_title.c_str(), 10, 10, window_size.x, window_size.y, SDL_WINDOW_SHOWN);
 }
 
 void Renderer::makeRenderer() {
-	renderer = Helper::SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_ACCELERATED);
+	if (backend == "software") {
+		// SDL's software renderer implements copies, rotation, flipping, color/alpha mods, blending and geometry on the CPU
+		framebuffer = SDL_CreateRGBSurfaceWithFormat(0, static_cast<int>(window_size.x), static_cast<int>(window_size.y), 32, SDL_PIXELFORMAT_RGBA32);
+		if (framebuffer == nullptr) {
+			std::cout << "error: could not create software framebuffer: " << SDL_GetError();
+			exit(0);
+		}
+		renderer = SDL_CreateSoftwareRenderer(framebuffer);
+		if (renderer == nullptr) {
+			std::cout << "error: could not create software renderer: " << SDL_GetError();
+			exit(0);
+		}
+		return;
+	}
+	// Helper paces frames itself. Waiting for vsync inside present would be counted as render time,
+	// so dynamic resolution goes without it.
+	Uint32 flags = dynamic_resolution ? SDL_RENDERER_ACCELERATED : SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_ACCELERATED;
+	renderer = Helper::SDL_CreateRenderer(window, -1, flags);
 }
 
 void Renderer::clear() {
@@ -90,69 +123,321 @@ void Renderer::RenderActors(std::vector<Actor*>& actors) {
 
 // Flushes all text in the text requests and renders
 void Renderer::FlushTextAndRender() {
+	RenderStats::BeginPass(RenderStats::TEXT);
+	RenderStats::RecordSubmitted(static_cast<int>(text_render_request_queue.size()));
 	for (TextRenderRequest& req : text_render_request_queue) {
 		if (TextDB::fonts.count(req.font_name) == 0 || TextDB::fonts[req.font_name].count(req.font_size) == 0) {
 			// we need to load the font first
 			TextDB::LoadFont(req.font_name, req.font_size);
 		}
 		SDL_Surface* surface = TTF_RenderText_Solid(TextDB::fonts[req.font_name][req.font_size], req.str_content.c_str(), {req.r, req.g, req.b, req.a});
+		RenderStats::RecordTextRasterization();
+		if (surface == nullptr) {
+			continue;
+		}
 		SDL_Texture* textTexture = SDL_CreateTextureFromSurface(renderer, surface);
 		SDL_FRect textRect = { static_cast<float>(req.x), static_cast<float>(req.y), static_cast<float>(surface->w), static_cast<float>(surface->h) };
 
 		drawImage(textTexture, textRect);
+		RenderStats::RecordDraw(textTexture, { req.r, req.g, req.b, req.a });
+
+		// Text textures are rebuilt every frame
+		SDL_DestroyTexture(textTexture);
+		SDL_FreeSurface(surface);
 	}
 	text_render_request_queue.clear();
-	//SDL_FreeSurface(surface);
 }
 
 void Renderer::FlushUIAndRender() {
-	// Sort requests by order, break ties via order calls occur
-	std::stable_sort(ui_render_request_queue.begin(), ui_render_request_queue.end(), [](const UIRenderRequest& a, const UIRenderRequest& b) {
-		return a.sorting_order < b.sorting_order; });
+	RenderStats::BeginPass(RenderStats::UI);
+	RenderStats::RecordSubmitted(static_cast<int>(ui_render_request_queue.size()));
 	for (UIRenderRequest& req : ui_render_request_queue) {
-		SDL_Texture* tex = ImageDB::GetImage(req.image_name);
+		req.tex = ImageDB::GetImage(req.image_name);
+		req.tex_id = ImageDB::GetImageID(req.tex);
+	}
 
-		// Set modifications
-		SDL_SetTextureColorMod(tex, req.r, req.g, req.b);
-		SDL_SetTextureAlphaMod(tex, req.a);
+	if (sort_by_render_state) {
+		// Sort requests by order, then group equal textures and tints so their mods are only set once
+		std::stable_sort(ui_render_request_queue.begin(), ui_render_request_queue.end(), [](const UIRenderRequest& a, const UIRenderRequest& b) {
+			if (a.sorting_order != b.sorting_order) return a.sorting_order < b.sorting_order;
+			if (a.tex_id != b.tex_id) return a.tex_id < b.tex_id;
+			return PackTint(a.r, a.g, a.b, a.a) < PackTint(b.r, b.g, b.b, b.a); });
+	}
+	else {
+		// Sort requests by order, break ties via order calls occur
+		std::stable_sort(ui_render_request_queue.begin(), ui_render_request_queue.end(), [](const UIRenderRequest& a, const UIRenderRequest& b) {
+			return a.sorting_order < b.sorting_order; });
+	}
+	if (retained_ui && !ui_layers_failed) {
+		RenderRetainedUI();
+	}
+	else {
+		for (UIRenderRequest& req : ui_render_request_queue) {
+			RenderUIRequest(req);
+		}
+	}
+	if (sort_by_render_state) {
+		RestoreMods();
+	}
+	ui_render_request_queue.clear();
 
-		float w, h;
-		Helper::SDL_QueryTexture(tex, &w, &h);
-		//req.width = static_cast<int>(w);
-		//req.height = static_cast<int>(h);
+	Primitives::FlushUI();
+}
+
+void Renderer::RenderUIRequest(const UIRenderRequest& req) {
+	SDL_Texture* tex = req.tex;
+
+	// Set modifications
+	SetMods(tex, req.r, req.g, req.b, req.a);
+
+	float w, h;
+	Helper::SDL_QueryTexture(tex, &w, &h);
 
-		SDL_FRect dst = { static_cast<float>(req.x), static_cast<float>(req.y), w, h };
+	SDL_FRect dst = { static_cast<float>(req.x), static_cast<float>(req.y), w, h };
 
-		Helper::SDL_RenderCopy(renderer, tex, nullptr, &dst);
+	Helper::SDL_RenderCopy(renderer, tex, nullptr, &dst);
+	RenderStats::RecordDraw(tex, { req.r, req.g, req.b, req.a });
 
-		// Reset modifications
+	// Reset modifications
+	if (!sort_by_render_state) {
 		ResetMods(tex);
 	}
-	ui_render_request_queue.clear();
+}
+
+SDL_Texture* Renderer::CreateUITarget() {
+	SDL_Texture* target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, static_cast<int>(window_size.x), static_cast<int>(window_size.y));
+	if (target == nullptr) {
+		return nullptr;
+	}
+	SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(
+		SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+		SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+	if (SDL_SetTextureBlendMode(target, premultiplied) != 0) {
+		// Semi transparent edges come out slightly darker, but the layer still works
+		SDL_SetTextureBlendMode(target, SDL_BLENDMODE_BLEND);
+	}
+	return target;
+}
+
+SDL_FRect Renderer::UIRequestBounds(std::deque<UIRenderRequest>::const_iterator begin, std::deque<UIRenderRequest>::const_iterator end) {
+	float min_x = window_size.x, min_y = window_size.y, max_x = 0.0f, max_y = 0.0f;
+	for (auto itr = begin; itr != end; itr++) {
+		float w = 0.0f, h = 0.0f;
+		Helper::SDL_QueryTexture(itr->tex, &w, &h);
+		min_x = std::min(min_x, static_cast<float>(itr->x));
+		min_y = std::min(min_y, static_cast<float>(itr->y));
+		max_x = std::max(max_x, static_cast<float>(itr->x) + w);
+		max_y = std::max(max_y, static_cast<float>(itr->y) + h);
+	}
+
+	// Clip to the target, an empty rect means nothing of the layer is on screen
+	min_x = std::max(min_x, 0.0f);
+	min_y = std::max(min_y, 0.0f);
+	max_x = std::min(max_x, window_size.x);
+	max_y = std::min(max_y, window_size.y);
+	return { min_x, min_y, std::max(max_x - min_x, 0.0f), std::max(max_y - min_y, 0.0f) };
+}
+
+void Renderer::RenderRetainedUI() {
+	for (auto& [order, layer] : ui_layers) {
+		layer.used = false;
+	}
+
+	// Bring every cached layer up to date, the composite only needs rebuilding if one changed
+	bool composite_dirty = ui_composite == nullptr;
+	std::vector<int> orders;
+	int layer_count = 0;
+	auto begin = ui_render_request_queue.cbegin();
+	while (begin != ui_render_request_queue.cend() && layer_count < retained_ui_max_layers) {
+		// Requests are sorted, so each sorting order is one contiguous run
+		auto end = begin;
+		while (end != ui_render_request_queue.cend() && end->sorting_order == begin->sorting_order) {
+			end++;
+		}
+		layer_count++;
+		orders.push_back(begin->sorting_order);
+
+		UILayer& layer = ui_layers[begin->sorting_order];
+		layer.used = true;
+		uint64_t hash = HashUIRequests(begin, end);
+		if (layer.target == nullptr || layer.hash != hash) {
+			if (layer.target == nullptr) {
+				layer.target = CreateUITarget();
+				if (layer.target == nullptr) {
+					// No render target support, draw UI directly from now on
+					ui_layers_failed = true;
+					ReleaseRetainedUI();
+					for (const UIRenderRequest& req : ui_render_request_queue) {
+						RenderUIRequest(req);
+					}
+					return;
+				}
+			}
+
+			// Blending into a transparent target leaves colors multiplied by alpha
+			SDL_SetRenderTarget(renderer, layer.target);
+			SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+			SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+			SDL_RenderClear(renderer);
+			for (auto itr = begin; itr != end; itr++) {
+				RenderUIRequest(*itr);
+			}
+			SDL_SetRenderTarget(renderer, nullptr);
+			layer.hash = hash;
+			layer.bounds = UIRequestBounds(begin, end);
+			composite_dirty = true;
+		}
+		begin = end;
+	}
+
+	// A layer appearing or disappearing changes the composite even if no cached layer did
+	if (orders != ui_composite_orders) {
+		ui_composite_orders = std::move(orders);
+		composite_dirty = true;
+	}
+
+	if (composite_dirty) {
+		if (ui_composite == nullptr) {
+			ui_composite = CreateUITarget();
+			if (ui_composite == nullptr) {
+				ui_layers_failed = true;
+				ReleaseRetainedUI();
+				for (const UIRenderRequest& req : ui_render_request_queue) {
+					RenderUIRequest(req);
+				}
+				return;
+			}
+		}
+
+		// Layers are premultiplied, so stacking them into a transparent target keeps it premultiplied
+		SDL_SetRenderTarget(renderer, ui_composite);
+		SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+		SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+		SDL_RenderClear(renderer);
+		float min_x = window_size.x, min_y = window_size.y, max_x = 0.0f, max_y = 0.0f;
+		for (int order : ui_composite_orders) {
+			const UILayer& layer = ui_layers[order];
+			if (layer.bounds.w <= 0.0f || layer.bounds.h <= 0.0f) {
+				continue;
+			}
+			Helper::SDL_RenderCopy(renderer, layer.target, &layer.bounds, &layer.bounds);
+			min_x = std::min(min_x, layer.bounds.x);
+			min_y = std::min(min_y, layer.bounds.y);
+			max_x = std::max(max_x, layer.bounds.x + layer.bounds.w);
+			max_y = std::max(max_y, layer.bounds.y + layer.bounds.h);
+		}
+		SDL_SetRenderTarget(renderer, nullptr);
+		ui_composite_bounds = { min_x, min_y, std::max(max_x - min_x, 0.0f), std::max(max_y - min_y, 0.0f) };
+	}
+
+	// One copy for every retained layer, limited to the area they cover
+	if (ui_composite_bounds.w > 0.0f && ui_composite_bounds.h > 0.0f) {
+		Helper::SDL_RenderCopy(renderer, ui_composite, &ui_composite_bounds, &ui_composite_bounds);
+		RenderStats::RecordDraw(ui_composite, { 255, 255, 255, 255 });
+	}
+
+	// Sorting orders past the layer limit are above every cached one, draw them directly
+	for (auto itr = begin; itr != ui_render_request_queue.cend(); itr++) {
+		RenderUIRequest(*itr);
+	}
+
+	// Layers that were not drawn this frame give their textures back
+	for (auto itr = ui_layers.begin(); itr != ui_layers.end();) {
+		if (!itr->second.used) {
+			SDL_DestroyTexture(itr->second.target);
+			itr = ui_layers.erase(itr);
+		}
+		else {
+			itr++;
+		}
+	}
+}
+
+uint64_t Renderer::HashUIRequests(std::deque<UIRenderRequest>::const_iterator begin, std::deque<UIRenderRequest>::const_iterator end) {
+	// FNV-1a over everything that affects the drawn pixels
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&hash](uint64_t value) {
+		hash ^= value;
+		hash *= 1099511628211ull;
+	};
+	for (auto itr = begin; itr != end; itr++) {
+		mix(reinterpret_cast<uintptr_t>(itr->tex));
+		mix(static_cast<uint32_t>(itr->x));
+		mix(static_cast<uint32_t>(itr->y));
+		mix(PackTint(itr->r, itr->g, itr->b, itr->a));
+	}
+	return hash;
 }
 
 void Renderer::FlushImageAndRender() {
-	SDL_FRect viewport = { 0, 0, Renderer::window_size.x, Renderer::window_size.y };
-	image_draw_request_queue.erase(std::remove_if(image_draw_request_queue.begin(), image_draw_request_queue.end(), [&viewport](const ImageDrawRequest& req) {
-		// Compute adjusted bounding box based on pivot
-		float xMin = req.x - (req.width * req.pivot_x);
-		float xMax = req.x + (req.width * (1.0f - req.pivot_x));
-		float yMin = req.y - (req.height * req.pivot_y);
-		float yMax = req.y + (req.height * (1.0f - req.pivot_y));
-
-		return xMax < viewport.x || xMin > viewport.x + viewport.w ||
-			yMax < viewport.y || yMin > viewport.y + viewport.h;
+	RenderStats::BeginPass(RenderStats::IMAGE);
+	float zoom_factor = Renderer::zoom_factor;
+	RenderStats::RecordSubmitted(static_cast<int>(image_draw_request_queue.size() + geometry_draw_request_queue.size()));
+
+	// Cull in the zoomed scene space images are drawn in, the visible area is the window divided by zoom
+	const float pixels_per_meter = 100;
+	float view_w = Renderer::window_size.x / zoom_factor;
+	float view_h = Renderer::window_size.y / zoom_factor;
+	size_t submitted_images = image_draw_request_queue.size();
+	image_draw_request_queue.erase(std::remove_if(image_draw_request_queue.begin(), image_draw_request_queue.end(), [&](const ImageDrawRequest& req) {
+		float w = req.width * glm::abs(req.scale_x);
+		float h = req.height * glm::abs(req.scale_y);
+		float pivot_x = req.pivot_x * w;
+		float pivot_y = req.pivot_y * h;
+
+		// Pivot position on screen, matching the placement below
+		float screen_x = (req.x - current_cam_pos.x) * pixels_per_meter + view_w * 0.5f;
+		float screen_y = (req.y - current_cam_pos.y) * pixels_per_meter + view_h * 0.5f;
+
+		float xMin = screen_x - pivot_x;
+		float xMax = screen_x + (w - pivot_x);
+		float yMin = screen_y - pivot_y;
+		float yMax = screen_y + (h - pivot_y);
+		if (req.rotation_degrees % 360 != 0) {
+			// Rotated images stay inside the circle through their farthest corner from the pivot
+			float reach_x = glm::max(pivot_x, w - pivot_x);
+			float reach_y = glm::max(pivot_y, h - pivot_y);
+			float radius = glm::sqrt(reach_x * reach_x + reach_y * reach_y);
+			xMin = screen_x - radius;
+			xMax = screen_x + radius;
+			yMin = screen_y - radius;
+			yMax = screen_y + radius;
+		}
+
+		return xMax < 0.0f || xMin > view_w || yMax < 0.0f || yMin > view_h;
 		}), image_draw_request_queue.end());
+	RenderStats::RecordCulled(static_cast<int>(submitted_images - image_draw_request_queue.size()));
+
+	if (sort_by_render_state) {
+		// Geometry ignores texture mods, so only images need grouping by texture and tint
+		std::stable_sort(image_draw_request_queue.begin(), image_draw_request_queue.end(), [](const ImageDrawRequest& a, const ImageDrawRequest& b) {
+			if (a.sorting_order != b.sorting_order) return a.sorting_order < b.sorting_order;
+			if (a.tex_id != b.tex_id) return a.tex_id < b.tex_id;
+			return PackTint(a.r, a.g, a.b, a.a) < PackTint(b.r, b.g, b.b, b.a); });
+	}
+	else {
+		std::stable_sort(image_draw_request_queue.begin(), image_draw_request_queue.end(), [](const ImageDrawRequest& a, const ImageDrawRequest& b) {
+			return a.sorting_order < b.sorting_order; });
+	}
 
-	std::stable_sort(image_draw_request_queue.begin(), image_draw_request_queue.end(), [](const ImageDrawRequest& a, const ImageDrawRequest& b) {
+	std::stable_sort(geometry_draw_request_queue.begin(), geometry_draw_request_queue.end(), [](const GeometryDrawRequest& a, const GeometryDrawRequest& b) {
 		return a.sorting_order < b.sorting_order; });
 
-	float zoom_factor = Renderer::zoom_factor;
-	SDL_RenderSetScale(renderer, zoom_factor, zoom_factor);
+	// Below native resolution the whole scene is shrunk by render_scale and stretched back afterwards
+	bool scaled = BeginWorldTarget();
+	float world_scale = scaled ? zoom_factor * render_scale : zoom_factor;
+	SDL_RenderSetScale(renderer, world_scale, world_scale);
+
+	auto next_geometry = geometry_draw_request_queue.begin();
 
 	// using instructor solution
 	for (ImageDrawRequest& req : image_draw_request_queue) {
-		const float pixels_per_meter = 100;
+		// Geometry shares the sorting order of images, drawing first on ties
+		while (next_geometry != geometry_draw_request_queue.end() && next_geometry->sorting_order <= req.sorting_order) {
+			RenderGeometry(*next_geometry);
+			next_geometry++;
+		}
+
 		glm::vec2 final_rendering_position = glm::vec2(req.x, req.y) - current_cam_pos;
 
 		SDL_FRect tex_rect;
@@ -180,38 +465,219 @@ void Renderer::FlushImageAndRender() {
 		tex_rect.y = (final_rendering_position.y * pixels_per_meter + cam_dimensions.y * 0.5f * (1.0f / zoom_factor) - pivot_point.y);
 
 		// Apply tint and alpha to texture
-		SDL_SetTextureColorMod(req.tex, req.r, req.g, req.b);
-		SDL_SetTextureAlphaMod(req.tex, req.a);
+		SetMods(req.tex, req.r, req.g, req.b, req.a);
 
 
 		// Draw image
 		Helper::SDL_RenderCopyEx(0, "", renderer, req.tex, NULL, &tex_rect, req.rotation_degrees, &pivot_point, static_cast<SDL_RendererFlip>(flip_mode));
+		RenderStats::RecordDraw(req.tex, { req.r, req.g, req.b, req.a });
 		
-		SDL_RenderSetScale(renderer, zoom_factor, zoom_factor);
+		SDL_RenderSetScale(renderer, world_scale, world_scale);
 
 		// Remove tint and alpha
-		ResetMods(req.tex);
+		if (!sort_by_render_state) {
+			ResetMods(req.tex);
+		}
 	}
+	if (sort_by_render_state) {
+		RestoreMods();
+	}
+
+	while (next_geometry != geometry_draw_request_queue.end()) {
+		RenderGeometry(*next_geometry);
+		next_geometry++;
+	}
+
+	// Lines, shapes and physics debug drawing go on top of the scene
+	Primitives::FlushWorld();
 
 	SDL_RenderSetScale(renderer, 1, 1);
+	if (scaled) {
+		EndWorldTarget();
+	}
 
 	image_draw_request_queue.clear();
+	geometry_draw_request_queue.clear();
 }
 
-void Renderer::FlushPixelAndRender() {
-	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-	for (PixelDrawRequest& req : pixel_draw_request_queue) {
-		SDL_SetRenderDrawColor(renderer, req.r, req.g, req.b, req.a);
-		SDL_RenderDrawPoint(renderer, req.x, req.y);
+bool Renderer::BeginWorldTarget() {
+	if (render_scale >= 1.0f || world_target_failed) {
+		return false;
+	}
+	if (world_target == nullptr) {
+		world_target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, static_cast<int>(window_size.x), static_cast<int>(window_size.y));
+		if (world_target == nullptr) {
+			world_target_failed = true;
+			return false;
+		}
+		// Smooth the upscale instead of showing blocky pixels
+		SDL_SetTextureScaleMode(world_target, SDL_ScaleModeLinear);
+	}
+	if (SDL_SetRenderTarget(renderer, world_target) != 0) {
+		world_target_failed = true;
+		return false;
+	}
+	SDL_SetRenderDrawColor(renderer, clear_color_r, clear_color_g, clear_color_b, clear_color_a);
+	SDL_RenderClear(renderer);
+	return true;
+}
+
+void Renderer::EndWorldTarget() {
+	SDL_SetRenderTarget(renderer, nullptr);
+	SDL_FRect src = { 0.0f, 0.0f, glm::round(window_size.x * render_scale), glm::round(window_size.y * render_scale) };
+	SDL_FRect dst = { 0.0f, 0.0f, window_size.x, window_size.y };
+	Helper::SDL_RenderCopy(renderer, world_target, &src, &dst);
+	RenderStats::RecordDraw(world_target, { 255, 255, 255, 255 });
+}
+
+void Renderer::UpdateResolutionScale(float render_ms) {
+	if (!dynamic_resolution) {
+		return;
+	}
+	average_render_ms = average_render_ms == 0.0f ? render_ms : average_render_ms * 0.9f + render_ms * 0.1f;
+	frames_since_scale_change++;
+
+	// Wait for the average to settle after every change so the scale does not oscillate
+	const int settle_frames = 30;
+	const int recover_frames = 120;
+	const float step = 0.05f;
+	if (average_render_ms > dynamic_resolution_budget_ms && frames_since_scale_change >= settle_frames && render_scale > dynamic_resolution_min_scale) {
+		render_scale = glm::max(dynamic_resolution_min_scale, render_scale - step);
+		frames_since_scale_change = 0;
+	}
+	else if (average_render_ms < dynamic_resolution_budget_ms * 0.8f && frames_since_scale_change >= recover_frames && render_scale < 1.0f) {
+		render_scale = glm::min(1.0f, render_scale + step);
+		frames_since_scale_change = 0;
+	}
+}
+
+float Renderer::GetResolutionScale() {
+	return render_scale;
+}
+
+void Renderer::SetHiddenTags(luabridge::LuaRef tags) {
+	hidden_tags = TagDB::MaskFromLua(tags);
+}
+
+bool Renderer::IsHidden(const Actor* a) {
+	return a != nullptr && (a->tags & hidden_tags) != 0;
+}
+
+void Renderer::RenderGeometry(const GeometryDrawRequest& req) {
+	const float pixels_per_meter = 100;
+	glm::ivec2 cam_dimensions = Renderer::window_size;
+
+	// Same placement as images: scene position relative to the camera, centered in the (zoomed) window
+	float offset_x = (req.x - current_cam_pos.x) * pixels_per_meter + cam_dimensions.x * 0.5f * (1.0f / zoom_factor);
+	float offset_y = (req.y - current_cam_pos.y) * pixels_per_meter + cam_dimensions.y * 0.5f * (1.0f / zoom_factor);
+
+	geometry_scratch.resize(req.num_vertices);
+	for (int i = 0; i < req.num_vertices; i++) {
+		geometry_scratch[i] = req.vertices[i];
+		geometry_scratch[i].position.x += offset_x;
+		geometry_scratch[i].position.y += offset_y;
+	}
+
+	int quads = req.num_vertices / 4;
+	const std::vector<int>& indices = GetQuadIndices(quads);
+	SDL_RenderGeometry(renderer, req.tex, geometry_scratch.data(), req.num_vertices, indices.data(), quads * 6);
+	RenderStats::RecordDraw(req.tex, { 255, 255, 255, 255 });
+}
+
+const std::vector<int>& Renderer::GetQuadIndices(int quads) {
+	int built = static_cast<int>(quad_indices.size() / 6);
+	if (built < quads) {
+		quad_indices.reserve(static_cast<size_t>(quads) * 6);
+		for (int q = built; q < quads; q++) {
+			int v = q * 4;
+			quad_indices.insert(quad_indices.end(), { v, v + 1, v + 2, v + 2, v + 3, v });
+		}
 	}
-	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
-	pixel_draw_request_queue.clear();
+	return quad_indices;
+}
+
+void Renderer::FlushPixelAndRender() {
+	RenderStats::BeginPass(RenderStats::PIXEL);
+	Canvas::Flush();
 }
 
 
 void Renderer::ResetMods(SDL_Texture* texture) {
 	SDL_SetTextureColorMod(texture, 255, 255, 255);
 	SDL_SetTextureAlphaMod(texture, 255);
+	RenderStats::RecordModChanges(2);
+}
+
+void Renderer::SetMods(SDL_Texture* texture, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+	if (!sort_by_render_state) {
+		SDL_SetTextureColorMod(texture, r, g, b);
+		SDL_SetTextureAlphaMod(texture, a);
+		RenderStats::RecordModChanges(2);
+		return;
+	}
+
+	// Textures are untinted until a state sorted pass modifies them
+	SDL_Color current = { 255, 255, 255, 255 };
+	auto itr = texture_mods.find(texture);
+	if (itr != texture_mods.end()) {
+		current = itr->second;
+	}
+	if (current.r != r || current.g != g || current.b != b) {
+		SDL_SetTextureColorMod(texture, r, g, b);
+		RenderStats::RecordModChanges(1);
+	}
+	if (current.a != a) {
+		SDL_SetTextureAlphaMod(texture, a);
+		RenderStats::RecordModChanges(1);
+	}
+	texture_mods[texture] = { r, g, b, a };
+}
+
+void Renderer::RestoreMods() {
+	for (auto& [texture, mods] : texture_mods) {
+		if (mods.r != 255 || mods.g != 255 || mods.b != 255) {
+			SDL_SetTextureColorMod(texture, 255, 255, 255);
+			RenderStats::RecordModChanges(1);
+		}
+		if (mods.a != 255) {
+			SDL_SetTextureAlphaMod(texture, 255);
+			RenderStats::RecordModChanges(1);
+		}
+	}
+	texture_mods.clear();
+}
+
+void Renderer::EndFrame() {
+	RenderStats::DrawOverlay();
+	RenderStats::EndFrame();
+}
+
+void Renderer::SetRetainedUI(bool enabled) {
+	retained_ui = enabled;
+	if (!enabled) {
+		ReleaseRetainedUI();
+	}
+}
+
+void Renderer::ReleaseRetainedUI() {
+	for (auto& [order, layer] : ui_layers) {
+		SDL_DestroyTexture(layer.target);
+	}
+	ui_layers.clear();
+	if (ui_composite != nullptr) {
+		SDL_DestroyTexture(ui_composite);
+		ui_composite = nullptr;
+	}
+	ui_composite_orders.clear();
+	ui_composite_bounds = { 0.0f, 0.0f, 0.0f, 0.0f };
+}
+
+void Renderer::SetStateSorting(bool enabled) {
+	sort_by_render_state = enabled;
+}
+
+int Renderer::GetStateChanges() {
+	return RenderStats::GetTotal("mod_changes");
 }
 
 void Renderer::DrawUI(std::string image_name, float x, float y) {
@@ -235,9 +701,13 @@ void Renderer::DrawEx(std::string image_name, float x, float y, float rotation_d
 	image_draw_request_queue.emplace_back(req);
 }
 
+void Renderer::DrawGeometry(SDL_Texture* tex, const std::vector<SDL_Vertex>& vertices, float x, float y, int sorting_order) {
+	GeometryDrawRequest req = { tex, vertices.data(), static_cast<int>(vertices.size()), x, y, sorting_order };
+	geometry_draw_request_queue.emplace_back(req);
+}
+
 void Renderer::DrawPixel(float x, float y, float r, float g, float b, float a) {
-	PixelDrawRequest req(x, y, r, g, b, a);
-	pixel_draw_request_queue.emplace_back(req);
+	Canvas::BlendPixel(x, y, r, g, b, a);
 }
 
 // ---------[ LUA CAM ] -------
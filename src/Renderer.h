@@ -7,7 +7,10 @@
 #include "SDL2_ttf/SDL_ttf.h"
 #include "TextDB.h"
 #include <deque>
+#include <unordered_map>
 #include "Helper.h"
+#include "lua.hpp"
+#include "LuaBridge/LuaBridge.h"
 
 
 struct DrawRequest {
@@ -35,6 +38,7 @@ struct ImageDrawRequest : public DrawRequest {
 	uint8_t a;
 	int sorting_order;
 	SDL_Texture* tex;
+	int tex_id; // see ImageDB::GetImageID
 
 	ImageDrawRequest(std::string _img, float _x, float _y);
 
@@ -69,21 +73,35 @@ struct UIRenderRequest : public DrawRequest {
 	uint8_t b;
 	uint8_t a;
 	int sorting_order;
+	SDL_Texture* tex = nullptr; // resolved when the UI pass is flushed
+	int tex_id = -1;
 	UIRenderRequest(std::string _img, float _x, float _y) : image_name(_img), r(255), g(255), b(255), a(255), sorting_order(0), DrawRequest{ static_cast<int>(_x), static_cast<int>(_y) } {}
 	UIRenderRequest(std::string _img, float _x, float _y, float _r, float _g, float _b, float _a, float _order) : image_name(_img), r(static_cast<int>(_r)), g(static_cast<int>(_g)), b(static_cast<int>(_b)), a(static_cast<int>(_a)), sorting_order(static_cast<int>(_order)), DrawRequest{ static_cast<int>(_x), static_cast<int>(_y) } {}
 };
 
-struct PixelDrawRequest : public DrawRequest {
-	uint8_t r;
-	uint8_t g;
-	uint8_t b;
-	uint8_t a;
-	PixelDrawRequest(float _x, float _y, float _r, float _g, float _b, float _a) :
-		DrawRequest{ static_cast<int>(_x), static_cast<int>(_y) },
-		r(static_cast<int>(_r)),
-		g(static_cast<int>(_g)),
-		b(static_cast<int>(_b)),
-		a(static_cast<int>(_a)) {};
+// A list of textured quads (4 vertices each) drawn with a single SDL_RenderGeometry call.
+// Vertices are in pixels relative to (x, y) in scene coordinates, and must stay alive until the frame is flushed.
+struct GeometryDrawRequest {
+	SDL_Texture* tex;
+	const SDL_Vertex* vertices;
+	int num_vertices;
+	float x;
+	float y;
+	int sorting_order;
+};
+
+// A retained UI layer: every UI request of one sorting order rendered into a window sized texture.
+struct UILayer {
+	SDL_Texture* target = nullptr;
+
+	// Hash of the requests the target was last rendered from
+	uint64_t hash = 0;
+
+	// Area of the target the requests drew into
+	SDL_FRect bounds = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	// Set when the layer was submitted this frame, unused layers are released
+	bool used = false;
 };
 
 //struct LineDrawRequest : public DrawRequest {
@@ -116,12 +134,59 @@ public:
 	// Flushes all Image requests in queue
 	static void FlushImageAndRender();
 
-	// Flushes all Pixel requests in queue
+	// Uploads and composites the pixel canvas
 	static void FlushPixelAndRender();
 
 	// Reset modifications to color and transparency on a texture
 	static void ResetMods(SDL_Texture* texture);
 
+	// Applies tint and alpha to a texture, skipping calls that would not change anything when sorting by render state
+	static void SetMods(SDL_Texture* texture, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+
+	// Resets every texture tinted during a state sorted pass
+	static void RestoreMods();
+
+	// Draws the stats overlay and publishes this frame's counters, call before presenting
+	static void EndFrame();
+
+	// ---- [ RESOLUTION SCALING ] ----
+
+	// Redirects the scene pass into world_target when rendering below native resolution, returns whether it did
+	static bool BeginWorldTarget();
+
+	// Upscales the used part of world_target over the whole window
+	static void EndWorldTarget();
+
+	// Adjusts render_scale from the time the last frame took to render
+	static void UpdateResolutionScale(float render_ms);
+
+	// Draws a single UI request with its tint and alpha
+	static void RenderUIRequest(const UIRenderRequest& req);
+
+	// Draws sorted UI requests from one cached composite, redrawing a layer only when its requests changed
+	static void RenderRetainedUI();
+
+	// Returns a hash of the UI requests in [begin, end)
+	static uint64_t HashUIRequests(std::deque<UIRenderRequest>::const_iterator begin, std::deque<UIRenderRequest>::const_iterator end);
+
+	// Returns the on screen area covered by the UI requests in [begin, end)
+	static SDL_FRect UIRequestBounds(std::deque<UIRenderRequest>::const_iterator begin, std::deque<UIRenderRequest>::const_iterator end);
+
+	// Creates a window sized, premultiplied alpha render target for retained UI
+	static SDL_Texture* CreateUITarget();
+
+	// Destroys every retained UI texture
+	static void ReleaseRetainedUI();
+
+	// Draws a GeometryDrawRequest, offsetting its vertices by the camera
+	static void RenderGeometry(const GeometryDrawRequest& req);
+
+	// Returns an index buffer describing at least [quads] quads
+	static const std::vector<int>& GetQuadIndices(int quads);
+
+	// Queues quads for the scene pass, sorted with images by sorting order (geometry first on ties)
+	static void DrawGeometry(SDL_Texture* tex, const std::vector<SDL_Vertex>& vertices, float x, float y, int sorting_order);
+
 	// --- [ LUA DRAW FUNCTIONS ] ----
 
 	// Draws an image to UI via screen coordinates, rendering in sorting order, breaking ties via order calls occurred.
@@ -136,9 +201,27 @@ public:
 	// Extended version of Draw
 	static void DrawEx(std::string image_name, float x, float y, float rotation_degrees, float scale_x, float scale_y, float pivot_x, float pivot_y, float r, float g, float b, float a, float sorting_order);
 
-	// Draws a single pixel
+	// Blends a single pixel into the canvas
 	static void DrawPixel(float x, float y, float r, float g, float b, float a);
 
+	// Returns the fraction of the window resolution the scene is currently rendered at
+	static float GetResolutionScale();
+
+	// Native components of actors carrying any of [tags] stop drawing, an empty table shows everything again
+	static void SetHiddenTags(luabridge::LuaRef tags);
+
+	// Returns whether the world pass skips [a]'s native drawing
+	static bool IsHidden(const Actor* a);
+
+	// Caches UI layers between frames, only re-rendering layers whose requests changed
+	static void SetRetainedUI(bool enabled);
+
+	// Reorders draws within a sorting order by texture and tint (overlapping draws in the same order may swap)
+	static void SetStateSorting(bool enabled);
+
+	// Returns the number of texture color/alpha mod changes made last frame
+	static int GetStateChanges();
+
 	// -------[ LUA CAMERA FUNCTIONS ] ---------
 
 
@@ -162,6 +245,12 @@ public:
 	inline static SDL_Window* window = nullptr;
 	inline static SDL_Renderer* renderer = nullptr;
 
+	// "gpu" draws to a window, "software" draws on the CPU into framebuffer with no window at all
+	inline static std::string backend = "gpu";
+
+	// In-memory RGBA target of the software backend
+	inline static SDL_Surface* framebuffer = nullptr;
+
 	inline static glm::vec2 window_position = glm::vec2(0, 30);
 	inline static glm::vec2 window_size = glm::ivec2(640, 360);
 
@@ -176,14 +265,73 @@ public:
 
 	inline static std::string game_title = "";
 
+	// When set, draws sharing a sorting order are grouped by texture and tint instead of call order
+	inline static bool sort_by_render_state = false;
+
+	// Tag mask of the actors left out of the world pass
+	inline static uint64_t hidden_tags = 0;
+
+	// Fraction of the window resolution the scene pass is rendered at, UI and text stay native
+	inline static float render_scale = 1.0f;
+
+	// When set, render_scale follows the measured render time instead of staying fixed
+	inline static bool dynamic_resolution = false;
+	inline static float dynamic_resolution_budget_ms = 12.0f;
+	inline static float dynamic_resolution_min_scale = 0.5f;
+
+	// When set, each UI sorting order is rendered into a cached texture that is reused while its requests stay the same
+	inline static bool retained_ui = false;
+
+	// Sorting orders beyond this many layers are drawn every frame
+	inline static int retained_ui_max_layers = 8;
+
+	// ---- [ RENDER STATE ] ----
+
+	// Current tint and alpha of textures modified during a state sorted pass
+	inline static std::unordered_map<SDL_Texture*, SDL_Color> texture_mods;
+
 	// ---- [ DRAW REQUEST QUEUES ] ----
 
 	inline static std::deque<ImageDrawRequest> image_draw_request_queue;
 	inline static std::deque<TextRenderRequest> text_render_request_queue;
 	inline static std::deque<UIRenderRequest> ui_render_request_queue;
-	inline static std::deque<PixelDrawRequest> pixel_draw_request_queue;
+	inline static std::vector<GeometryDrawRequest> geometry_draw_request_queue;
 	//inline static std::deque<LineDrawRequest> line_draw_request_queue;
 
+	// ---- [ GEOMETRY BUFFERS ] ----
+
+	// Camera-offset copy of the vertices of the geometry request being drawn
+	inline static std::vector<SDL_Vertex> geometry_scratch;
+
+	// Shared 0,1,2,2,3,0 pattern for quad lists
+	inline static std::vector<int> quad_indices;
+
+	// ---- [ RETAINED UI STATE ] ----
+
+	// Cached layers by sorting order
+	inline static std::unordered_map<int, UILayer> ui_layers;
+
+	// Every cached layer stacked in sorting order, the only retained texture drawn to the screen
+	inline static SDL_Texture* ui_composite = nullptr;
+
+	// Sorting orders the composite was built from, and the area they cover
+	inline static std::vector<int> ui_composite_orders;
+	inline static SDL_FRect ui_composite_bounds = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	// Set if the renderer cannot render to textures, UI is then always drawn directly
+	inline static bool ui_layers_failed = false;
+
+	// ---- [ RESOLUTION SCALING STATE ] ----
+
+	// Window sized target, only the top left render_scale portion is drawn to each frame
+	inline static SDL_Texture* world_target = nullptr;
+
+	// Set if the renderer cannot render to textures, the scene is then always drawn natively
+	inline static bool world_target_failed = false;
+
+	// Smoothed render time and frames since render_scale last changed
+	inline static float average_render_ms = 0.0f;
+	inline static int frames_since_scale_change = 0;
 
 };
 
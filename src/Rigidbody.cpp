@@ -1,5 +1,6 @@
 #include "Rigidbody.h"
 #include "World.h"
+#include "TagDB.h"
 
 void ContactListener::BeginContact(b2Contact* contact) {
 	b2Fixture* fixtureA = contact->GetFixtureA();
@@ -17,15 +18,15 @@ void ContactListener::BeginContact(b2Contact* contact) {
 	c.point = world_manifold.points[0];
 
 	if (fixtureA->IsSensor() && fixtureB->IsSensor()) {
-		c.other = b;
+		c.other = ActorPool::GetHandle(b);
 		a->OnTriggerEnter(c);
-		c.other = a;
+		c.other = ActorPool::GetHandle(a);
 		b->OnTriggerEnter(c);
 	}
 	else if (!fixtureA->IsSensor() && !fixtureB->IsSensor()) {
-		c.other = b;
+		c.other = ActorPool::GetHandle(b);
 		a->OnCollisionEnter(c);
-		c.other = a;
+		c.other = ActorPool::GetHandle(a);
 		b->OnCollisionEnter(c);
 	}
 }
@@ -49,21 +50,115 @@ void ContactListener::EndContact(b2Contact* contact) {
 	// ALSO: Check Actor::305
 
 	if (fixtureA->IsSensor() && fixtureB->IsSensor()) {
-		c.other = b;
+		c.other = ActorPool::GetHandle(b);
 		a->OnTriggerExit(c);
-		c.other = a;
+		c.other = ActorPool::GetHandle(a);
 		b->OnTriggerExit(c);
 	}
 	else if (!fixtureA->IsSensor() && !fixtureB->IsSensor()) {
-		c.other = b;
+		c.other = ActorPool::GetHandle(b);
 		a->OnCollisionExit(c);
-		c.other = a;
+		c.other = ActorPool::GetHandle(a);
 		b->OnCollisionExit(c);
 	}
 }
 
+bool ContactFilter::ShouldCollide(b2Fixture* fixtureA, b2Fixture* fixtureB) {
+	if (!b2ContactFilter::ShouldCollide(fixtureA, fixtureB)) {
+		return false;
+	}
+	Rigidbody* a = reinterpret_cast<Rigidbody*>(fixtureA->GetBody()->GetUserData().pointer);
+	Rigidbody* b = reinterpret_cast<Rigidbody*>(fixtureB->GetBody()->GetUserData().pointer);
+	if (a == nullptr || b == nullptr) {
+		return true;
+	}
+	uint64_t a_tags = a->actor->tags;
+	uint64_t b_tags = b->actor->tags;
+	return (b_tags == 0 || (a->collides_with & b_tags)) && (a_tags == 0 || (b->collides_with & a_tags));
+}
+
 void Rigidbody::OnDestroy() {
+	// Destroyed before its first OnStart
+	if (body == nullptr) {
+		return;
+	}
 	World::world->DestroyBody(body);
+	body = nullptr;
+}
+
+void Rigidbody::ReadValues(const rapidjson::Value& value) {
+	if (value.HasMember("x")) {
+		x = value["x"].GetFloat();
+	}
+	if (value.HasMember("y")) {
+		y = value["y"].GetFloat();
+	}
+	if (value.HasMember("body_type")) {
+		body_type = value["body_type"].GetString();
+	}
+	if (value.HasMember("precise")) {
+		precise = value["precise"].GetBool();
+	}
+	if (value.HasMember("gravity_scale")) {
+		gravity_scale = value["gravity_scale"].GetFloat();
+	}
+	if (value.HasMember("density")) {
+		density = value["density"].GetFloat();
+	}
+	if (value.HasMember("angular_friction")) {
+		angular_friction = value["angular_friction"].GetFloat();
+	}
+	if (value.HasMember("rotation")) {
+		rotation = value["rotation"].GetFloat();
+	}
+	if (value.HasMember("has_collider")) {
+		has_collider = value["has_collider"].GetBool();
+	}
+	if (value.HasMember("has_trigger")) {
+		has_trigger = value["has_trigger"].GetBool();
+	}
+	if (value.HasMember("collider_type")) {
+		collider_type = value["collider_type"].GetString();
+	}
+	if (value.HasMember("width")) {
+		width = value["width"].GetFloat();
+	}
+	if (value.HasMember("height")) {
+		height = value["height"].GetFloat();
+	}
+	if (value.HasMember("radius")) {
+		radius = value["radius"].GetFloat();
+	}
+	if (value.HasMember("friction")) {
+		friction = value["friction"].GetFloat();
+	}
+	if (value.HasMember("bounciness")) {
+		bounciness = value["bounciness"].GetFloat();
+	}
+	if (value.HasMember("trigger_type")) {
+		trigger_type = value["trigger_type"].GetString();
+	}
+	if (value.HasMember("trigger_radius")) {
+		trigger_radius = value["trigger_radius"].GetFloat();
+	}
+	if (value.HasMember("trigger_height")) {
+		trigger_height = value["trigger_height"].GetFloat();
+	}
+	if (value.HasMember("trigger_width")) {
+		trigger_width = value["trigger_width"].GetFloat();
+	}
+	if (value.HasMember("collides_with")) {
+		collides_with = TagDB::ParseMask(value["collides_with"]);
+	}
+}
+
+void Rigidbody::Refilter() {
+	if (body == nullptr) {
+		return;
+	}
+	for (b2Fixture* fixture = body->GetFixtureList(); fixture != nullptr; fixture = fixture->GetNext()) {
+		fixture->Refilter();
+	}
 }
 
 void Rigidbody::OnStart() {
@@ -86,6 +181,8 @@ void Rigidbody::OnStart() {
 	body_def.angularDamping = angular_friction;
 	body_def.gravityScale = gravity_scale;
 	body_def.angle = rotation * (b2_pi / 180.0f);
+	// ContactFilter reads collides_with and the actor's tags through this
+	body_def.userData.pointer = reinterpret_cast<uintptr_t>(this);
 
 	body = World::world->CreateBody(&body_def);
 
@@ -2,6 +2,7 @@
 #include <string>
 #include "box2d/box2d.h"
 #include "Component.h"
+#include "ActorPool.h"
 #include "Actor.h"
 
 class Actor;
@@ -14,9 +15,15 @@ public:
 	void EndContact(b2Contact* contact) override;
 };
 
+// Runs Box2D's category test, then lets each side's collides_with veto the other side's actor tags
+class ContactFilter : public b2ContactFilter {
+public:
+	bool ShouldCollide(b2Fixture* fixtureA, b2Fixture* fixtureB) override;
+};
+
 class Collision {
 public:
-	Actor* other;
+	ActorHandle other;
 	b2Vec2 point;
 	b2Vec2 relative_velocity;
 	b2Vec2 normal;
@@ -65,6 +72,9 @@ public:
 	float trigger_height = 1.0f;
 	float trigger_radius = 0.5f;
 
+	// Tag mask of the actors this body collides with and triggers, untagged actors always pass
+	uint64_t collides_with = ~uint64_t(0);
+
 	// --- [ LUA FUNCTIONS ] ---
 	
 	// Returns Vector2 of position
@@ -107,14 +117,20 @@ public:
 
 	b2Vec2 GetRightDirection();
 
+	// Sets the variables present in a component's json, leaving the rest as they are
+	void ReadValues(const rapidjson::Value& value);
+
 	// --- [ LIFE CYCLE FUNC ] ---
 
 	void OnStart();
 
 	void OnDestroy();
 
+	// Makes Box2D test this body's contacts against the filter again, e.g. after its actor's tags change
+	void Refilter();
+
 	// --- [ Box2D BODY ] ---
-	b2Body* body;
+	b2Body* body = nullptr;
 
 
 };
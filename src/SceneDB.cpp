@@ -8,6 +8,12 @@
 #include <algorithm>
 #include <thread>
 #include "ComponentManager.h"
+#include "LuaDispatch.h"
+#include "ComponentDB.h"
+#include "ActorPool.h"
+#include "ComponentRegistry.h"
+#include "TagDB.h"
+#include "TemplatePool.h"
 
 
 
@@ -21,21 +27,21 @@ Actor* SceneDB::InitializeActor(rapidjson::Value& arr) {
 			std::cout << "error: template " << template_name << " is missing";
 			exit(0);
 		}
-		// Template exists
-		rapidjson::Document& d = TemplateDB::templates[template_name];
-
-		Actor* a = new Actor();
-		// create actor from template
-		a->CreateActorFromValue(d);
+		Actor* a = ActorPool::Allocate(next_id++);
+		// create actor from the compiled template
+		a->CreateFromPrototype(TemplateDB::prototypes[template_name]);
 		// add in overrides from json
 		a->CreateActorFromValue(arr);
-		a->id = next_id++;
 		a->template_name = template_name;
+		IndexActorName(a);
+		TagDB::IndexActor(a);
 		return a;
 	}
 	else {
-		Actor* a = new Actor(arr);
-		a->id = next_id++;
+		Actor* a = ActorPool::Allocate(next_id++);
+		a->CreateActorFromValue(arr);
+		IndexActorName(a);
+		TagDB::IndexActor(a);
 		return a;
 	}
 }
@@ -48,7 +54,7 @@ bool SceneDB::LoadScene(std::string scene) {
 	// Reset everything for new scene load
 	for (Actor* a : actors) {
 		if (!a->dontdelete) {
-			SceneDB::Destroy(a);
+			SceneDB::DestroyActor(a);
 		}
 	}
 	std::string path = "./resources/scenes/" + scene + ".scene";
@@ -66,6 +72,7 @@ bool SceneDB::LoadScene(std::string scene) {
 		for (auto& actor : scene_json["actors"].GetArray()) {
 			Actor* a = InitializeActor(actor);
 			actors.push_back((a));
+			LuaDispatch::RegisterActor(a);
 
 			// If actors have relevant components, flag them and add to queue
 			if (a->OnStartComponentQueue.size() > 0) {
@@ -79,98 +86,133 @@ bool SceneDB::LoadScene(std::string scene) {
 			}
 		}
 	}
+	if (scene_json.HasMember("pools") && scene_json["pools"].IsObject()) {
+		// Template name -> how many actors to build up front
+		for (auto itr = scene_json["pools"].MemberBegin(); itr != scene_json["pools"].MemberEnd(); ++itr) {
+			std::string template_name = itr->name.GetString();
+			if (!TemplateDB::CheckTemplateExists(template_name)) {
+				std::cout << "error: template " << template_name << " is missing";
+				exit(0);
+			}
+			TemplatePool::Prewarm(template_name, itr->value.GetInt());
+		}
+	}
 	return true;
 }
 
 void SceneDB::ProcessComponentUpdates(Actor* a) {
+	// Take the batch, changes made by OnDestroy below queue the actor again for the next one
+	std::vector<std::string> removes;
+	std::vector<int> adds;
+	removes.swap(a->pending_removes);
+	adds.swap(a->pending_adds);
+	a->component_changes_queued = false;
+
 	// Check for removals
-	if (ComponentsToRemove.count(a) != 0) {
-		for (std::string comp : ComponentsToRemove[a]) {
-			std::shared_ptr<Component> c = a->components[comp];
-			if (a->components[comp]->hasStart) {
-				a->OnStartComponentQueue.erase(std::remove(a->OnStartComponentQueue.begin(), a->OnStartComponentQueue.end(), c), a->OnStartComponentQueue.end());
-			}
-			if (a->components[comp]->hasUpdate) {
-				a->OnUpdateComponentQueue.erase(std::remove(a->OnUpdateComponentQueue.begin(), a->OnUpdateComponentQueue.end(), c), a->OnUpdateComponentQueue.end());
-			}
-			if (a->components[comp]->hasLateUpdate) {
-				a->OnLateUpdateComponentQueue.erase(std::remove(a->OnLateUpdateComponentQueue.begin(), a->OnLateUpdateComponentQueue.end(), c), a->OnLateUpdateComponentQueue.end());
-			}
-			if (a->components[comp]->hasDestroy) {
-				// call onDestroy
-				if (c->type == "Rigidbody") {
-					Rigidbody* r = c->componentRef->cast<Rigidbody*>();
-					r->OnDestroy();
-				}
-				else {
-					std::shared_ptr<luabridge::LuaRef> ref = (a->components[comp])->componentRef;
-					(*ref)["OnDestroy"](*ref);
-				}
-				// remove from queues
-				a->OnDeleteQueue.erase(std::remove(a->OnDeleteQueue.begin(), a->OnDeleteQueue.end(), c), a->OnDeleteQueue.end());
-			}
-			a->components.erase(comp);
+	std::vector<int> removed_slots;
+	for (const std::string& comp : removes) {
+		auto itr = a->components.find(comp);
+		if (itr == a->components.end()) {
+			continue;
 		}
-		ComponentsToRemove.clear();
+		int slot = itr->second;
+		Component& c = a->component_pool[slot];
+		LuaDispatch::UnregisterComponent(c);
+		if (c.hasDestroy) {
+			CallOnDestroy(c);
+		}
+		a->EraseComponent(comp);
+		removed_slots.push_back(slot);
+	}
+	// Every queue refers to the slots, which are reused once freed
+	a->RemoveComponentsFromQueues(removed_slots);
+	for (int slot : removed_slots) {
+		a->FreeSlot(slot);
 	}
 	// Check for additions
-	if (ComponentsToAdd.count(a) != 0) {
-		for (std::shared_ptr<Component>& comp : ComponentsToAdd[a]) {
-			a->AddComponentToQueues(*comp);
-			a->components.insert(std::make_pair(comp->key, comp));
-		}
-		ComponentsToAdd.clear();
+	for (int slot : adds) {
+		Component& c = a->component_pool[slot];
+		a->AddComponentToQueues(slot);
+		a->InsertComponent(c.key, slot);
+		LuaDispatch::RegisterComponent(a, c);
 	}
 }
 
-void SceneDB::RemoveActorFromQueue(Actor* a, std::vector<Actor*>& queue) {
-	auto it = std::find(queue.begin(), queue.end(), a);
-	if (it != queue.end()) {
-		queue.erase(it);
+void SceneDB::CallOnDestroy(Component& c) {
+	if (c.type_id == COMPONENT_TYPE_RIGIDBODY) {
+		Rigidbody* r = static_cast<Rigidbody*>(c.native);
+		r->OnDestroy();
+	}
+	else {
+		luabridge::LuaRef& ref = *c.componentRef;
+		ref["OnDestroy"](ref);
+	}
+}
+
+void SceneDB::QueueComponentChanges(Actor* a) {
+	if (!a->component_changes_queued) {
+		a->component_changes_queued = true;
+		ActorsComponentChanged.push_back(a);
 	}
 }
 
 void SceneDB::ProcessActorUpdates() {
-	while (!ActorsToAdd.empty()) {
+	for (Actor* a : ActorsToAdd) {
 		// Add actor to actors
-		Actor* a = ActorsToAdd.back();
-		ActorsToAdd.pop_back();
-
 		actors.push_back(a);
+		LuaDispatch::RegisterActor(a);
 
 		// If actors have relevant components, flag them and add to queue
 		if (a->OnStartComponentQueue.size() > 0) {
-			OnStartActorQueue.push_back(actors.back());
+			OnStartActorQueue.push_back(a);
 		}
 		if (a->OnUpdateComponentQueue.size() > 0) {
-			OnUpdateActorQueue.push_back(actors.back());
+			OnUpdateActorQueue.push_back(a);
 		}
 		if (a->OnLateUpdateComponentQueue.size() > 0) {
-			OnLateUpdateActorQueue.push_back(actors.back());
+			OnLateUpdateActorQueue.push_back(a);
 		}
 	}
-	while (!ActorsToRemove.empty()) {
-		Actor* a = ActorsToRemove.back();
-		ActorsToRemove.pop_back();
+	ActorsToAdd.clear();
+
+	if (!ActorsToRemove.empty()) {
+		// OnDestroy may destroy more actors, which join this batch
+		for (size_t i = 0; i < ActorsToRemove.size(); i++) {
+			Actor* a = ActorsToRemove[i];
 
-		// remove actor from actors
-		auto it = std::remove(actors.begin(), actors.end(), a);
-		if (it != actors.end()) {
-			actors.erase(it, actors.end());
+			// Call all of actor's OnDestroy components
+			for (int slot : a->OnDeleteQueue) {
+				CallOnDestroy(a->component_pool[slot]);
+			}
+			LuaDispatch::UnregisterActor(a);
+			ComponentRegistry::RemoveActor(a);
 		}
-		// remove actor from all queues
-		RemoveActorFromQueue(a, OnStartActorQueue);
-		RemoveActorFromQueue(a, OnUpdateActorQueue);
-		RemoveActorFromQueue(a, OnLateUpdateActorQueue);
-
-		// Call all of actor's OnDestroy components
-		for (auto ptr : a->OnDeleteQueue) {
-			(*ptr->componentRef)["OnDestroy"](*ptr->componentRef);
+
+		// Every actor in the batch is flagged deleted, so one stable pass per list drops them all,
+		// including the name and tag lists the batch touched
+		UnindexActorNames(ActorsToRemove);
+		TagDB::UnindexActors(ActorsToRemove);
+		auto is_deleted = [](const Actor* a) { return a->deleted; };
+		for (std::vector<Actor*>* list : { &actors, &OnStartActorQueue, &OnUpdateActorQueue, &OnLateUpdateActorQueue }) {
+			list->erase(std::remove_if(list->begin(), list->end(), is_deleted), list->end());
 		}
 
-		delete a;
+		// Pending component changes live on the actor and die with it
+		for (Actor* a : ActorsToRemove) {
+			if (!TemplatePool::Park(a)) {
+				ActorPool::Release(a);
+			}
+		}
+		ActorsToRemove.clear();
 	}
-	for (Actor* a : ActorsComponentChanged) {
+
+	// OnDestroy in ProcessComponentUpdates may queue more actors, which are handled in this pass too
+	for (size_t i = 0; i < ActorsComponentChanged.size(); i++) {
+		Actor* a = ActorsComponentChanged[i];
+		// Released actors have nothing pending, and a reused slot is only processed if it queued itself
+		if (!a->component_changes_queued) {
+			continue;
+		}
 		// Check if actor gains a new component type to queue for
 		int start = a->OnStartComponentQueue.size();
 		int update = a->OnUpdateComponentQueue.size();
@@ -186,6 +228,7 @@ void SceneDB::ProcessActorUpdates() {
 			OnLateUpdateActorQueue.push_back(a);
 		}
 	}
+	ActorsComponentChanged.clear();
 }
 
 
@@ -193,81 +236,184 @@ void SceneDB::ProcessActorUpdates() {
 
 
 luabridge::LuaRef SceneDB::Instantiate(std::string template_name) {
-	// Use a template, then overwrite it with arr
 	if (!TemplateDB::CheckTemplateExists(template_name)) {
 		// Template does not exist
 		std::cout << "error: template " << template_name << " is missing";
 		exit(0);
 	}
-	// Template exists
-	rapidjson::Document& d = TemplateDB::templates[template_name];
+	Actor* a = SpawnFromTemplate(template_name);
+	return luabridge::LuaRef(ComponentManager::lua_state, ActorPool::GetHandle(a));
+}
+
+luabridge::LuaRef SceneDB::InstantiateMany(std::string template_name, int count, luabridge::LuaRef init) {
+	if (!TemplateDB::CheckTemplateExists(template_name)) {
+		// Template does not exist
+		std::cout << "error: template " << template_name << " is missing";
+		exit(0);
+	}
+	lua_State* lua_state = ComponentManager::lua_state;
+	luabridge::LuaRef table = luabridge::newTable(lua_state);
+
+	// Read { component_key = { field = value or array } } once rather than per actor
+	std::vector<FieldOverride> overrides;
+	if (init.isTable()) {
+		for (luabridge::Iterator comp_itr(init); !comp_itr.isNil(); ++comp_itr) {
+			if (!comp_itr.key().isString() || !comp_itr.value().isTable()) {
+				continue;
+			}
+			std::string key = comp_itr.key().cast<std::string>();
+			for (luabridge::Iterator field_itr(comp_itr.value()); !field_itr.isNil(); ++field_itr) {
+				if (field_itr.key().isString()) {
+					overrides.push_back({ key, field_itr.key().cast<std::string>(), field_itr.value(), field_itr.value().isTable() });
+				}
+			}
+		}
+	}
+
+	ActorsToAdd.reserve(ActorsToAdd.size() + std::max(count, 0));
+	for (int i = 1; i <= count; i++) {
+		Actor* a = SpawnFromTemplate(template_name, &overrides, i);
+		// Lua tables are 1-indexed
+		table[i] = luabridge::LuaRef(lua_state, ActorPool::GetHandle(a));
+	}
+	return table;
+}
 
-	Actor* a = new Actor();
-	// create actor from template
-	a->CreateActorFromValue(d);
-	// add in overrides from json
-	a->id = next_id++;
-	a->template_name = template_name;
+Actor* SceneDB::SpawnFromTemplate(const std::string& template_name, const std::vector<FieldOverride>* overrides, int index) {
+	// Reuse a parked actor of the template if there is one
+	Actor* a = TemplatePool::Acquire(template_name, next_id);
+	bool reused = a != nullptr;
+	if (reused) {
+		next_id++;
+	}
+	else {
+		a = ActorPool::Allocate(next_id++);
+		// create actor from the compiled template
+		a->CreateFromPrototype(TemplateDB::prototypes[template_name]);
+		a->template_name = template_name;
+	}
+	if (overrides != nullptr) {
+		for (const FieldOverride& o : *overrides) {
+			auto itr = a->components.find(o.key);
+			if (itr == a->components.end()) {
+				continue;
+			}
+			luabridge::LuaRef value = o.per_instance ? luabridge::LuaRef(o.value[index]) : o.value;
+			if (value.isNil()) {
+				continue;
+			}
+			Component& c = a->component_pool[itr->second];
+			if (o.field == "enabled") {
+				// The flag lifecycle dispatch reads, not just the field scripts see
+				c.SetEnabled(value.cast<bool>());
+			}
+			else {
+				a->GetProxy(c)[o.field] = value;
+			}
+		}
+	}
+	IndexActorName(a);
+	TagDB::IndexActor(a);
 	ActorsToAdd.push_back(a);
-	return luabridge::LuaRef(ComponentManager::lua_state, a);
+	if (reused) {
+		TemplatePool::CallOnReset(a);
+	}
+	return a;
 }
 
-void SceneDB::Destroy(Actor* a) {
+void SceneDB::Destroy(ActorHandle handle) {
+	Actor* a = handle.Get();
+	if (a != nullptr && !a->deleted) {
+		DestroyActor(a);
+	}
+}
+
+void SceneDB::DestroyActor(Actor* a) {
+	// Releasing an actor twice would put its slot on the free list twice
+	if (a->deleted) {
+		return;
+	}
 	ActorsToRemove.push_back(a);
 	a->deleted = true;
 	// set all components' enabled to false
 	for (auto& entry : a->components) {
-		std::shared_ptr<Component> c = entry.second;
-		(*c->componentRef)["enabled"] = false;
+		a->component_pool[entry.second].SetEnabled(false);
 	}
 }
 
 
 luabridge::LuaRef SceneDB::Find(std::string name) {
-	for (Actor* a : actors) {
-		if (a->name == name && !a->deleted) {
-			// TODO: Check if we need to make this a shared_ptr instead.
-			return luabridge::LuaRef(ComponentManager::lua_state, a);
-		}
-	}
-	for (Actor* a : ActorsToAdd) {
-		if (a->name == name && !a->deleted) {
-			// TODO: Check if we need to make this a shared_ptr instead.
-			return luabridge::LuaRef(ComponentManager::lua_state, a);
+	auto itr = actors_by_name.find(name);
+	if (itr != actors_by_name.end()) {
+		// Lowest id first, actors added this frame are already indexed
+		for (Actor* a : itr->second) {
+			if (!a->deleted) {
+				return luabridge::LuaRef(ComponentManager::lua_state, ActorPool::GetHandle(a));
+			}
 		}
 	}
 	return luabridge::LuaRef(ComponentManager::lua_state);
 }
 
-luabridge::LuaRef SceneDB::FindAll(std::string name) {
-	// Find all matches and sort them by key order
-	std::vector<Actor*> matches;
-	for (Actor* actor : actors) {
-		if (actor->name == name && !actor->deleted) {
-			matches.push_back(actor);
-		}
-	}
-	for (Actor* actor : ActorsToAdd) {
-		if (actor->name == name && !actor->deleted) {
-			matches.push_back(actor);
-		}
+luabridge::LuaRef SceneDB::FindByID(uint32_t id) {
+	Actor* a = ActorPool::FindByID(id);
+	if (a == nullptr || a->deleted) {
+		return luabridge::LuaRef(ComponentManager::lua_state);
 	}
-	//std::sort(matches.begin(), matches.end(), [](const Actor& a, const Actor& b) { ret);
+	return luabridge::LuaRef(ComponentManager::lua_state, ActorPool::GetHandle(a));
+}
 
-	// Make a table and insert all matches into it
+luabridge::LuaRef SceneDB::FindAll(std::string name) {
 	lua_State* lua_state = ComponentManager::lua_state;
-
 	luabridge::LuaRef table = luabridge::newTable(lua_state);
 
-	// Add {i : LuaRef to Component} to table
-	for (uint32_t i = 0; i < matches.size(); i++) {
-		// Lua tables are 1-indexed
-		table[i + 1] = luabridge::LuaRef(ComponentManager::lua_state, matches[i]);
+	auto itr = actors_by_name.find(name);
+	if (itr == actors_by_name.end()) {
+		return table;
+	}
+	// Add {i : handle} to table in id order
+	int i = 1;
+	for (Actor* a : itr->second) {
+		if (!a->deleted) {
+			// Lua tables are 1-indexed
+			table[i++] = luabridge::LuaRef(lua_state, ActorPool::GetHandle(a));
+		}
 	}
-
 	return table;
 }
 
+void SceneDB::IndexActorName(Actor* a) {
+	std::vector<Actor*>& named = actors_by_name[a->name];
+	auto position = std::lower_bound(named.begin(), named.end(), a, [](const Actor* x, const Actor* y) {
+		return x->id < y->id; });
+	named.insert(position, a);
+}
+
+void SceneDB::UnindexActorNames(const std::vector<Actor*>& removed) {
+	// 1,000 bullets named "Bullet" share one list, which is compacted once rather than searched per bullet
+	std::vector<const std::string*> names;
+	for (Actor* a : removed) {
+		names.push_back(&a->name);
+	}
+	std::sort(names.begin(), names.end(), [](const std::string* x, const std::string* y) {
+		return *x < *y; });
+	names.erase(std::unique(names.begin(), names.end(), [](const std::string* x, const std::string* y) {
+		return *x == *y; }), names.end());
+
+	for (const std::string* name : names) {
+		auto itr = actors_by_name.find(*name);
+		if (itr == actors_by_name.end()) {
+			continue;
+		}
+		std::vector<Actor*>& named = itr->second;
+		named.erase(std::remove_if(named.begin(), named.end(), [](const Actor* a) {
+			return a->deleted; }), named.end());
+		if (named.empty()) {
+			actors_by_name.erase(itr);
+		}
+	}
+}
+
 // --- [ APPLICATION FUNCTIONS ] ---
 void SceneDB::Quit() {
 	exit(0);
@@ -303,6 +449,9 @@ std::string SceneDB::GetCurrent() {
 	return current_scene_name;
  }
 
-void SceneDB::DontDestroy(Actor* a) {
-	a->dontdelete = true;
+void SceneDB::DontDestroy(ActorHandle handle) {
+	Actor* a = handle.Get();
+	if (a != nullptr) {
+		a->dontdelete = true;
+	}
  }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "TemplateDB.h"
 #include "glm/glm.hpp"
 #include "Component.h"
+#include "ActorPool.h"
 #include <set>
 
 
@@ -22,29 +23,69 @@ public:
 	inline static std::string current_scene_name = "";
 	inline static std::string next_scene_name = "";
 
-	// Processes all actors to add, remove, and component updates
+	// Applies the frame's structural changes in one batch: actor additions, actor removals, then
+	// each changed actor's component removals and additions. Cost is linear in the number of
+	// changes plus one compaction pass over actors and the actor queues when any actor is removed.
 	static void ProcessActorUpdates();
 	static void ProcessComponentUpdates(Actor* a);
-	static void RemoveActorFromQueue(Actor* a, std::vector<Actor*>& queue);
+
+	// Adds [a] to ActorsComponentChanged once per batch, its changes are in its pending lists
+	static void QueueComponentChanges(Actor* a);
+
+	// Runs OnDestroy of a Lua component, or tears down a native one
+	static void CallOnDestroy(Component& c);
 
 	inline static std::vector<Actor*> OnStartActorQueue;
 	inline static std::vector<Actor*> OnUpdateActorQueue;
 	inline static std::vector<Actor*> OnLateUpdateActorQueue;
 
 	inline static std::vector<Actor*> ActorsComponentChanged;
-	inline static std::unordered_map<Actor*, std::vector<std::shared_ptr<Component>>> ComponentsToAdd;
-	inline static std::unordered_map<Actor*, std::vector<std::string>> ComponentsToRemove;
 
+	// Applied in the order they were queued
 	inline static std::vector<Actor*> ActorsToAdd;
 	inline static std::vector<Actor*> ActorsToRemove;
 
+	// Name -> every actor with it (pending adds included) in id order, for Find and FindAll
+	inline static std::unordered_map<std::string, std::vector<Actor*>> actors_by_name;
+
+	// Adds a newly created actor to actors_by_name, call once its name is set
+	static void IndexActorName(Actor* a);
+
+	// Removes a batch of deleted actors from actors_by_name before they are released, one pass per name
+	static void UnindexActorNames(const std::vector<Actor*>& removed);
+
+	// Returns the live actor with [name] and the lowest id, or nil
 	static luabridge::LuaRef Find(std::string name);
 
+	// Returns the actor with [id], or nil if there is none or it is being destroyed
+	static luabridge::LuaRef FindByID(uint32_t id);
+
+	// Returns every live actor with [name] in id order
 	static luabridge::LuaRef FindAll(std::string name);
 
 	static luabridge::LuaRef Instantiate(std::string template_name);
 
-	static void Destroy(Actor* a);
+	// Instantiates [count] actors in one batch and returns them as an array. [init] may hold
+	// { component_key = { field = value } }, where a table value gives each actor its own entry.
+	static luabridge::LuaRef InstantiateMany(std::string template_name, int count, luabridge::LuaRef init);
+
+	// One field of InstantiateMany's [init], [per_instance] when the value is an array indexed per actor
+	struct FieldOverride {
+		std::string key;
+		std::string field;
+		luabridge::LuaRef value;
+		bool per_instance;
+	};
+
+	// Builds (or reuses) an actor of an existing template and queues it to be added next frame.
+	// [overrides] are applied with entry [index] of per instance values, before a reused actor's OnReset.
+	static Actor* SpawnFromTemplate(const std::string& template_name, const std::vector<FieldOverride>* overrides = nullptr, int index = 0);
+
+	// Destroys the actor behind [handle], stale handles are ignored
+	static void Destroy(ActorHandle handle);
+
+	// Disables the actor's components and queues it for release at the end of the frame
+	static void DestroyActor(Actor* a);
 
 	// --- [ APPLICATION FUNCTIONS ] ---
 	static void Quit();
@@ -60,5 +101,5 @@ public:
 
 	static std::string GetCurrent();
 
-	static void DontDestroy(Actor* a);
+	static void DontDestroy(ActorHandle handle);
 };
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "TagDB.h"
+#include "Actor.h"
+#include "ActorPool.h"
+#include "ComponentManager.h"
+#include <algorithm>
+#include <iostream>
+
+int TagDB::InternTag(const std::string& name) {
+	auto itr = tag_bits.find(name);
+	if (itr != tag_bits.end()) {
+		return itr->second;
+	}
+	if (static_cast<int>(tag_names.size()) >= max_tags) {
+		std::cout << "error: tag " << name << " exceeds the limit of " << max_tags << " tags";
+		exit(0);
+	}
+	int bit = static_cast<int>(tag_names.size());
+	tag_bits[name] = bit;
+	tag_names.push_back(name);
+	return bit;
+}
+
+int TagDB::GetTagBit(const std::string& name) {
+	auto itr = tag_bits.find(name);
+	return itr == tag_bits.end() ? -1 : itr->second;
+}
+
+uint64_t TagDB::ParseMask(const rapidjson::Value& value) {
+	uint64_t mask = 0;
+	if (value.IsString()) {
+		mask |= uint64_t(1) << InternTag(value.GetString());
+	}
+	else if (value.IsArray()) {
+		for (auto& tag : value.GetArray()) {
+			if (tag.IsString()) {
+				mask |= uint64_t(1) << InternTag(tag.GetString());
+			}
+		}
+	}
+	return mask;
+}
+
+uint64_t TagDB::MaskFromLua(const luabridge::LuaRef& tags, bool intern, bool* all_known) {
+	std::vector<std::string> names;
+	if (tags.isString()) {
+		names.push_back(tags.cast<std::string>());
+	}
+	else if (tags.isTable()) {
+		// Lua tables are 1-indexed
+		for (int i = 1; i <= tags.length(); i++) {
+			luabridge::LuaRef tag = tags[i];
+			if (tag.isString()) {
+				names.push_back(tag.cast<std::string>());
+			}
+		}
+	}
+	uint64_t mask = 0;
+	for (const std::string& name : names) {
+		int bit = intern ? InternTag(name) : GetTagBit(name);
+		if (bit < 0) {
+			if (all_known != nullptr) {
+				*all_known = false;
+			}
+			continue;
+		}
+		mask |= uint64_t(1) << bit;
+	}
+	return mask;
+}
+
+void TagDB::IndexActor(Actor* a) {
+	for (int bit = 0; bit < max_tags; bit++) {
+		if (a->tags & (uint64_t(1) << bit)) {
+			Insert(tagged[bit], a);
+		}
+	}
+}
+
+void TagDB::UnindexActors(const std::vector<Actor*>& removed) {
+	uint64_t touched = 0;
+	for (Actor* a : removed) {
+		touched |= a->tags;
+	}
+	for (int bit = 0; bit < max_tags; bit++) {
+		if (touched & (uint64_t(1) << bit)) {
+			std::vector<Actor*>& list = tagged[bit];
+			list.erase(std::remove_if(list.begin(), list.end(), [](const Actor* a) {
+				return a->deleted; }), list.end());
+		}
+	}
+}
+
+void TagDB::AddTags(Actor* a, uint64_t mask) {
+	uint64_t added = mask & ~a->tags;
+	for (int bit = 0; bit < max_tags; bit++) {
+		if (added & (uint64_t(1) << bit)) {
+			Insert(tagged[bit], a);
+		}
+	}
+	a->tags |= added;
+}
+
+void TagDB::RemoveTags(Actor* a, uint64_t mask) {
+	uint64_t removed = mask & a->tags;
+	for (int bit = 0; bit < max_tags; bit++) {
+		if (removed & (uint64_t(1) << bit)) {
+			Erase(tagged[bit], a);
+		}
+	}
+	a->tags &= ~removed;
+}
+
+// --- [ LUA FUNCTIONS ] ---
+
+luabridge::LuaRef TagDB::FindAllWithAnyTag(luabridge::LuaRef tags) {
+	lua_State* lua_state = ComponentManager::lua_state;
+	luabridge::LuaRef table = luabridge::newTable(lua_state);
+
+	uint64_t mask = MaskFromLua(tags, false);
+	std::vector<Actor*> matches;
+	for (int bit = 0; bit < max_tags; bit++) {
+		if (mask & (uint64_t(1) << bit)) {
+			matches.insert(matches.end(), tagged[bit].begin(), tagged[bit].end());
+		}
+	}
+	// Each list is in id order, but an actor with several of the tags shows up once per tag
+	std::sort(matches.begin(), matches.end(), [](const Actor* x, const Actor* y) {
+		return x->id < y->id; });
+	matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+
+	int i = 1;
+	for (Actor* a : matches) {
+		if (!a->deleted) {
+			// Lua tables are 1-indexed
+			table[i++] = luabridge::LuaRef(lua_state, ActorPool::GetHandle(a));
+		}
+	}
+	return table;
+}
+
+luabridge::LuaRef TagDB::FindAllWithAllTags(luabridge::LuaRef tags) {
+	lua_State* lua_state = ComponentManager::lua_state;
+	luabridge::LuaRef table = luabridge::newTable(lua_state);
+
+	bool all_known = true;
+	uint64_t mask = MaskFromLua(tags, false, &all_known);
+	if (!all_known || mask == 0) {
+		return table;
+	}
+	// Walk the shortest list and test the rest of the mask per actor
+	std::vector<Actor*>* shortest = nullptr;
+	for (int bit = 0; bit < max_tags; bit++) {
+		if ((mask & (uint64_t(1) << bit)) && (shortest == nullptr || tagged[bit].size() < shortest->size())) {
+			shortest = &tagged[bit];
+		}
+	}
+	int i = 1;
+	for (Actor* a : *shortest) {
+		if (!a->deleted && (a->tags & mask) == mask) {
+			// Lua tables are 1-indexed
+			table[i++] = luabridge::LuaRef(lua_state, ActorPool::GetHandle(a));
+		}
+	}
+	return table;
+}
+
+// --- [ HELPER FUNCTIONS ] ---
+
+void TagDB::Insert(std::vector<Actor*>& list, Actor* a) {
+	auto position = std::lower_bound(list.begin(), list.end(), a, [](const Actor* x, const Actor* y) {
+		return x->id < y->id; });
+	list.insert(position, a);
+}
+
+void TagDB::Erase(std::vector<Actor*>& list, Actor* a) {
+	auto position = std::lower_bound(list.begin(), list.end(), a, [](const Actor* x, const Actor* y) {
+		return x->id < y->id; });
+	if (position != list.end() && *position == a) {
+		list.erase(position);
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "rapidjson/document.h"
+#include "lua.hpp"
+#include "LuaBridge/LuaBridge.h"
+
+class Actor;
+
+// Tags are interned to one bit each, so an actor's tags are a single 64 bit mask that gameplay
+// queries, physics filtering and the renderer all test the same way. Every tag also keeps the
+// actors carrying it in id order, so queries only walk actors that can match.
+class TagDB
+{
+public:
+	inline static const int max_tags = 64;
+
+	// Returns the bit of [name], interning it if it is new
+	static int InternTag(const std::string& name);
+
+	// Returns the bit of [name], or -1 if no actor, rigidbody or camera has used it yet
+	static int GetTagBit(const std::string& name);
+
+	// Parses a tag name or an array of tag names
+	static uint64_t ParseMask(const rapidjson::Value& value);
+
+	// Parses a tag name or a table of tag names. With [intern] false unknown names are left out
+	// of the mask and [all_known], if given, is cleared.
+	static uint64_t MaskFromLua(const luabridge::LuaRef& tags, bool intern = true, bool* all_known = nullptr);
+
+	// Adds the actor to the list of every tag it carries, call once its tags are parsed
+	static void IndexActor(Actor* a);
+
+	// Drops a batch of deleted actors from the lists of the tags they carry, one pass per tag,
+	// call before releasing them
+	static void UnindexActors(const std::vector<Actor*>& removed);
+
+	// Sets or clears tag bits on a live actor and keeps the lists in step
+	static void AddTags(Actor* a, uint64_t mask);
+	static void RemoveTags(Actor* a, uint64_t mask);
+
+	// --- [ LUA FUNCTIONS ] ---
+
+	// Returns every live actor carrying at least one of [tags], in id order
+	static luabridge::LuaRef FindAllWithAnyTag(luabridge::LuaRef tags);
+
+	// Returns every live actor carrying all of [tags], in id order
+	static luabridge::LuaRef FindAllWithAllTags(luabridge::LuaRef tags);
+
+private:
+	inline static std::unordered_map<std::string, int> tag_bits;
+	inline static std::vector<std::string> tag_names;
+
+	// Tag bit -> actors carrying it, sorted by id
+	inline static std::vector<Actor*> tagged[max_tags];
+
+	static void Insert(std::vector<Actor*>& list, Actor* a);
+	static void Erase(std::vector<Actor*>& list, Actor* a);
+};
@@ -1,5 +1,12 @@
 #include "TemplateDB.h"
 #include "EngineUtils.h"
+#include "ComponentDB.h"
+#include "ComponentManager.h"
+#include "ParticleSystem.h"
+#include "Rigidbody.h"
+#include "TagDB.h"
+#include "Tilemap.h"
+#include <algorithm>
 
 
 bool TemplateDB::CheckTemplateExists(std::string template_name) {
@@ -20,6 +27,74 @@ void TemplateDB::LoadTemplates() {
 			EngineUtils::ReadJsonFile(dir_entry.path().string(), tmp);
 			std::string tmpname = dir_entry.path().filename().stem().string();
 			templates.emplace(tmpname, std::move(tmp));
+			Compile(tmpname, templates[tmpname]);
 		}
 	}
-}
\ No newline at end of file
+}
+
+void TemplateDB::Compile(const std::string& template_name, const rapidjson::Value& value) {
+	TemplatePrototype& prototype = prototypes[template_name];
+	if (value.HasMember("name")) {
+		prototype.name = value["name"].GetString();
+	}
+	if (value.HasMember("tags")) {
+		prototype.tags = TagDB::ParseMask(value["tags"]);
+	}
+	if (!value.HasMember("components") || !value["components"].IsObject()) {
+		return;
+	}
+	lua_State* lua_state = ComponentManager::lua_state;
+	const rapidjson::Value& comp_arr = value["components"];
+	for (auto compItr = comp_arr.MemberBegin(); compItr != comp_arr.MemberEnd(); compItr++) {
+		ComponentPrototype component;
+		component.key = compItr->name.GetString();
+		if (compItr->value.HasMember("type") && compItr->value["type"].IsString()) {
+			component.type = compItr->value["type"].GetString();
+		}
+		component.type_id = ComponentDB::GetTypeID(component.type);
+
+		if (component.type == "Rigidbody") {
+			component.rigidbody = std::make_shared<Rigidbody>();
+			component.rigidbody->ReadValues(compItr->value);
+		}
+		else if (component.type == "ParticleSystem") {
+			component.particle_system = std::make_shared<ParticleSystem>();
+			component.particle_system->ReadValues(compItr->value);
+		}
+		else if (component.type == "Tilemap") {
+			component.tilemap = std::make_shared<Tilemap>();
+			component.tilemap->ReadValues(compItr->value);
+		}
+		else if (ComponentDB::CheckComponentExists(component.type)) {
+			// The same fields Actor::CreateComponent would set
+			luabridge::LuaRef fields = luabridge::newTable(lua_state);
+			fields["key"] = component.key;
+			fields["enabled"] = true;
+			for (auto varItr = compItr->value.MemberBegin(); varItr != compItr->value.MemberEnd(); varItr++) {
+				std::string varName = varItr->name.GetString();
+				if (varItr->value.IsString()) {
+					fields[varName] = varItr->value.GetString();
+				}
+				else if (varItr->value.IsBool()) {
+					fields[varName] = varItr->value.GetBool();
+				}
+				else if (varItr->value.IsInt()) {
+					fields[varName] = varItr->value.GetInt();
+				}
+				else if (varItr->value.IsFloat()) {
+					fields[varName] = varItr->value.GetFloat();
+				}
+			}
+			component.field_count = static_cast<int>(compItr->value.MemberCount()) + 2;
+			component.enabled = fields["enabled"];
+			component.fields = std::make_shared<luabridge::LuaRef>(fields);
+		}
+		prototype.components.push_back(component);
+	}
+
+	for (int i = 0; i < static_cast<int>(prototype.components.size()); i++) {
+		prototype.by_key.push_back(i);
+	}
+	std::sort(prototype.by_key.begin(), prototype.by_key.end(), [&prototype](int x, int y) {
+		return prototype.components[x].key < prototype.components[y].key; });
+}
@@ -1,14 +1,55 @@
 #pragma once
 #include <string>
 #include <unordered_map>
+#include <memory>
+#include <vector>
 #include "Actor.h"
 #include "ImageDB.h"
 #include "rapidjson/document.h"
+
+class Rigidbody;
+class ParticleSystem;
+class Tilemap;
+
+// A template component as its json builds it, copied by every actor made from the template
+struct ComponentPrototype {
+	std::string key;
+	std::string type;
+	int type_id = -1;
+
+	// Exactly one is set for a native component
+	std::shared_ptr<Rigidbody> rigidbody;
+	std::shared_ptr<ParticleSystem> particle_system;
+	std::shared_ptr<Tilemap> tilemap;
+
+	// Raw fields of a Lua component, cloned into each instance. Unset if the type does not exist,
+	// which is reported when the template is instantiated.
+	std::shared_ptr<luabridge::LuaRef> fields;
+	int field_count = 0;
+	bool enabled = true;
+};
+
+// A template compiled once, so instantiating it copies values instead of reading json
+struct TemplatePrototype {
+	std::string name;
+	uint64_t tags = 0;
+
+	// In json order
+	std::vector<ComponentPrototype> components;
+
+	// Indices into components, sorted by key
+	std::vector<int> by_key;
+};
+
 class TemplateDB
 {
 public:
 	static bool CheckTemplateExists(std::string template_name);
 	static void LoadTemplates();
 	inline static std::unordered_map<std::string, rapidjson::Document> templates;
-};
+	inline static std::unordered_map<std::string, TemplatePrototype> prototypes;
 
+private:
+	// Builds the prototype of a loaded template
+	static void Compile(const std::string& template_name, const rapidjson::Value& value);
+};
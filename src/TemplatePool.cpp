@@ -0,0 +1,164 @@
+#include "TemplatePool.h"
+#include "Actor.h"
+#include "ActorPool.h"
+#include "ComponentDB.h"
+#include "ComponentManager.h"
+#include "ComponentRegistry.h"
+#include "EngineUtils.h"
+#include "ParticleSystem.h"
+#include "Rigidbody.h"
+#include "TemplateDB.h"
+#include "Tilemap.h"
+#include <algorithm>
+
+void TemplatePool::Prewarm(const std::string& template_name, int count) {
+	Pool& pool = GetPool(template_name);
+	pool.capacity = std::max(pool.capacity, count);
+	const TemplatePrototype& prototype = TemplateDB::prototypes[template_name];
+
+	while (static_cast<int>(pool.parked.size()) < count) {
+		// Never live, so it needs no id and is not indexed anywhere but the component registry
+		Actor* a = ActorPool::Allocate(0);
+		a->CreateFromPrototype(prototype);
+		a->template_name = template_name;
+		ComponentRegistry::RemoveActor(a);
+		a->deleted = true;
+		if (!Park(a)) {
+			ActorPool::Release(a);
+			return;
+		}
+	}
+}
+
+Actor* TemplatePool::Acquire(const std::string& template_name, uint32_t id) {
+	auto itr = pools.find(template_name);
+	if (itr == pools.end() || itr->second.parked.empty()) {
+		return nullptr;
+	}
+	Pool& pool = itr->second;
+	Actor* a = pool.parked.back();
+	pool.parked.pop_back();
+	const TemplatePrototype& prototype = TemplateDB::prototypes[template_name];
+
+	ActorPool::Revive(a, id);
+	a->name = prototype.name;
+	a->tags = prototype.tags;
+	a->deleted = false;
+	a->dontdelete = false;
+
+	lua_State* lua_state = ComponentManager::lua_state;
+	for (const ComponentPrototype& component : prototype.components) {
+		Component& c = a->component_pool[a->components[component.key]];
+		if (component.rigidbody) {
+			// The old body was destroyed with the actor, OnStart makes a new one
+			Rigidbody* r = static_cast<Rigidbody*>(c.native);
+			*r = *component.rigidbody;
+			r->actor = a;
+			r->key = component.key;
+			r->type = "Rigidbody";
+		}
+		else if (component.particle_system) {
+			ParticleSystem* p = static_cast<ParticleSystem*>(c.native);
+			*p = *component.particle_system;
+			p->actor = a;
+			p->key = component.key;
+			p->type = "ParticleSystem";
+		}
+		else if (component.tilemap) {
+			Tilemap* t = static_cast<Tilemap*>(c.native);
+			*t = *component.tilemap;
+			t->actor = a;
+			t->key = component.key;
+			t->type = "Tilemap";
+		}
+		else if (c.prototype) {
+			// Drop the table a script may have asked for, the next one is built from the template again
+			if (c.componentRef) {
+				ComponentDB::UntrackInstance(&c);
+				c.instance = nullptr;
+				c.componentRef.reset();
+			}
+			c.fields.reset();
+			c.enabled = component.enabled;
+		}
+		else {
+			// Same table and metatable, only the fields go back to the template's
+			c.componentRef->push(lua_state);
+			component.fields->push(lua_state);
+			ComponentManager::CopyFields(-1, -2);
+			lua_pop(lua_state, 2);
+			a->InjectConvenienceReferences(c.componentRef);
+			c.enabled = (*c.componentRef)["enabled"];
+		}
+	}
+	ComponentRegistry::AddActor(a);
+	a->ResetQueues();
+	return a;
+}
+
+void TemplatePool::CallOnReset(Actor* a) {
+	const TemplatePrototype& prototype = TemplateDB::prototypes[a->template_name];
+	// Key order, like the other lifecycle functions
+	for (int index : prototype.by_key) {
+		const ComponentPrototype& component = prototype.components[index];
+		if (!component.fields || ComponentDB::IsDataOnly(component.type_id)) {
+			continue;
+		}
+		luabridge::LuaRef& ref = *a->component_pool[a->components[component.key]].componentRef;
+		try {
+			luabridge::LuaRef on_reset = ref["OnReset"];
+			if (on_reset.isFunction()) {
+				on_reset(ref);
+			}
+		}
+		catch (const luabridge::LuaException& e) {
+			EngineUtils::ReportError(a->name, e);
+		}
+	}
+}
+
+bool TemplatePool::Park(Actor* a) {
+	if (a->template_name.empty()) {
+		return false;
+	}
+	Pool& pool = GetPool(a->template_name);
+	if (static_cast<int>(pool.parked.size()) >= pool.capacity || !MatchesPrototype(TemplateDB::prototypes[a->template_name], a)) {
+		return false;
+	}
+	ActorPool::Retire(a);
+	// Removals queued before the destroy never happen, Acquire restores the component anyway
+	a->pending_removes.clear();
+	a->component_changes_queued = false;
+	pool.parked.push_back(a);
+	return true;
+}
+
+// --- [ HELPER FUNCTIONS ] ---
+
+TemplatePool::Pool& TemplatePool::GetPool(const std::string& template_name) {
+	auto itr = pools.find(template_name);
+	if (itr != pools.end()) {
+		return itr->second;
+	}
+	Pool& pool = pools[template_name];
+	rapidjson::Document& d = TemplateDB::templates[template_name];
+	if (d.IsObject() && d.HasMember("pool_size") && d["pool_size"].IsInt()) {
+		pool.capacity = d["pool_size"].GetInt();
+	}
+	return pool;
+}
+
+bool TemplatePool::MatchesPrototype(const TemplatePrototype& prototype, const Actor* a) {
+	// Components added at runtime are either pending or already in components and the pool
+	if (!a->pending_adds.empty() || a->components.size() != prototype.components.size() || a->component_pool.size() != prototype.components.size()) {
+		return false;
+	}
+	for (const ComponentPrototype& component : prototype.components) {
+		// A Lua type that does not exist never got this far
+		auto itr = a->components.find(component.key);
+		if (itr == a->components.end() || a->component_pool[itr->second].type_id != component.type_id) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Actor;
+struct TemplatePrototype;
+
+// Keeps destroyed actors of high churn templates instead of releasing them. A parked actor keeps its
+// components, their Lua tables and metatables, and is handed back to Actor.Instantiate with every field
+// reset to the template's prototype, so a steady stream of spawns allocates nothing.
+// Pooling is opt in: "pool_size" in a template, or "pools" in a scene, which also builds actors up front.
+class TemplatePool
+{
+public:
+	// Builds actors of [template_name] until [count] are parked, raising its pool size if needed
+	static void Prewarm(const std::string& template_name, int count);
+
+	// Returns a parked actor of [template_name] reset to its prototype and live under [id], or nullptr
+	static Actor* Acquire(const std::string& template_name, uint32_t id);
+
+	// Calls OnReset on the Lua components of an actor returned by Acquire, call once it is indexed
+	static void CallOnReset(Actor* a);
+
+	// Parks an actor being destroyed, returns false if it should be released instead: its template is
+	// not pooled, the pool is full, or components were added or removed since it was built
+	static bool Park(Actor* a);
+
+private:
+	struct Pool {
+		int capacity = 0;
+		std::vector<Actor*> parked;
+	};
+
+	inline static std::unordered_map<std::string, Pool> pools;
+
+	// Returns the pool of [template_name], reading its "pool_size" the first time
+	static Pool& GetPool(const std::string& template_name);
+
+	// Returns whether [a] still has exactly the components of the prototype
+	static bool MatchesPrototype(const TemplatePrototype& prototype, const Actor* a);
+};
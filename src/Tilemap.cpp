@@ -0,0 +1,281 @@
+#include "Tilemap.h"
+#include "ImageDB.h"
+#include "Renderer.h"
+#include "EngineUtils.h"
+#include "Helper.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+// --- JSON ---
+
+void Tilemap::ReadValues(const rapidjson::Value& value) {
+	if (value.HasMember("x")) {
+		x = value["x"].GetFloat();
+	}
+	if (value.HasMember("y")) {
+		y = value["y"].GetFloat();
+	}
+	if (value.HasMember("atlas")) {
+		atlas = value["atlas"].GetString();
+	}
+	if (value.HasMember("tile_width")) {
+		tile_width = value["tile_width"].GetInt();
+	}
+	if (value.HasMember("tile_height")) {
+		tile_height = value["tile_height"].GetInt();
+	}
+	if (value.HasMember("chunk_size")) {
+		chunk_size = value["chunk_size"].GetInt();
+	}
+	if (value.HasMember("sorting_order")) {
+		sorting_order = value["sorting_order"].GetInt();
+	}
+	if (value.HasMember("layers")) {
+		// Replaces the layers of a template instead of adding to them
+		layer_files.clear();
+		const rapidjson::Value& layers = value["layers"];
+		if (layers.IsString()) {
+			layer_files.push_back(layers.GetString());
+		}
+		else if (layers.IsArray()) {
+			for (auto& layer : layers.GetArray()) {
+				layer_files.push_back(layer.GetString());
+			}
+		}
+	}
+}
+
+// --- LIFECYCLE FUNCTIONS ---
+
+void Tilemap::OnStart() {
+	atlas_texture = ImageDB::GetImage(atlas);
+	if (atlas_texture == nullptr) {
+		std::cout << "error: tilemap atlas " << atlas << " is missing";
+		exit(0);
+	}
+	if (tile_width < 1) tile_width = 1;
+	if (tile_height < 1) tile_height = 1;
+	if (chunk_size < 1) chunk_size = 1;
+
+	Helper::SDL_QueryTexture(atlas_texture, &atlas_width, &atlas_height);
+	atlas_columns = std::max(1, static_cast<int>(atlas_width) / tile_width);
+	atlas_rows = std::max(1, static_cast<int>(atlas_height) / tile_height);
+
+	for (const std::string& file_name : layer_files) {
+		LoadLayerFile(file_name);
+	}
+
+	chunks_x = (width + chunk_size - 1) / chunk_size;
+	chunks_y = (height + chunk_size - 1) / chunk_size;
+	chunks.assign(static_cast<size_t>(layer_count) * chunks_x * chunks_y, TilemapChunk());
+	visible_vertices.assign(layer_count, std::vector<SDL_Vertex>());
+}
+
+void Tilemap::OnUpdate() {
+	if (layer_count == 0 || atlas_texture == nullptr || Renderer::IsHidden(actor)) {
+		return;
+	}
+	const float pixels_per_meter = 100.0f;
+
+	// Visible area of the world in pixels, relative to the map origin
+	float view_w = Renderer::window_size.x / Renderer::zoom_factor;
+	float view_h = Renderer::window_size.y / Renderer::zoom_factor;
+	float view_x = (Renderer::current_cam_pos.x - x) * pixels_per_meter - view_w * 0.5f;
+	float view_y = (Renderer::current_cam_pos.y - y) * pixels_per_meter - view_h * 0.5f;
+
+	// The camera may still move this frame, so keep a one chunk margin around the view
+	float chunk_px_w = static_cast<float>(chunk_size * tile_width);
+	float chunk_px_h = static_cast<float>(chunk_size * tile_height);
+	int first_x = std::max(0, static_cast<int>(std::floor(view_x / chunk_px_w)) - 1);
+	int first_y = std::max(0, static_cast<int>(std::floor(view_y / chunk_px_h)) - 1);
+	int last_x = std::min(chunks_x - 1, static_cast<int>(std::floor((view_x + view_w) / chunk_px_w)) + 1);
+	int last_y = std::min(chunks_y - 1, static_cast<int>(std::floor((view_y + view_h) / chunk_px_h)) + 1);
+
+	for (int layer = 0; layer < layer_count; layer++) {
+		std::vector<SDL_Vertex>& out = visible_vertices[layer];
+		out.clear();
+		for (int cy = first_y; cy <= last_y; cy++) {
+			for (int cx = first_x; cx <= last_x; cx++) {
+				TilemapChunk& chunk = chunks[(static_cast<size_t>(layer) * chunks_y + cy) * chunks_x + cx];
+				if (chunk.dirty) {
+					BakeChunk(layer, cx, cy);
+				}
+				out.insert(out.end(), chunk.vertices.begin(), chunk.vertices.end());
+			}
+		}
+		if (!out.empty()) {
+			Renderer::DrawGeometry(atlas_texture, out, x, y, sorting_order);
+		}
+	}
+}
+
+// --- LUA FUNCTIONS ---
+
+int Tilemap::GetTile(int tile_x, int tile_y) {
+	return GetLayerTile(0, tile_x, tile_y);
+}
+
+void Tilemap::SetTile(int tile_x, int tile_y, int tile) {
+	SetLayerTile(0, tile_x, tile_y, tile);
+}
+
+int Tilemap::GetLayerTile(int layer, int tile_x, int tile_y) {
+	if (layer < 0 || layer >= layer_count || tile_x < 0 || tile_x >= width || tile_y < 0 || tile_y >= height) {
+		return -1;
+	}
+	return tiles[(static_cast<size_t>(layer) * height + tile_y) * width + tile_x];
+}
+
+void Tilemap::SetLayerTile(int layer, int tile_x, int tile_y, int tile) {
+	if (layer < 0 || layer >= layer_count || tile_x < 0 || tile_x >= width || tile_y < 0 || tile_y >= height) {
+		return;
+	}
+	int32_t& current = tiles[(static_cast<size_t>(layer) * height + tile_y) * width + tile_x];
+	if (current == tile) {
+		return;
+	}
+	current = tile;
+
+	// Only the chunk holding this tile needs to be re-baked
+	int cx = tile_x / chunk_size;
+	int cy = tile_y / chunk_size;
+	chunks[(static_cast<size_t>(layer) * chunks_y + cy) * chunks_x + cx].dirty = true;
+}
+
+int Tilemap::GetWidth() {
+	return width;
+}
+
+int Tilemap::GetHeight() {
+	return height;
+}
+
+int Tilemap::GetLayerCount() {
+	return layer_count;
+}
+
+void Tilemap::AddLayer(std::string file_name) {
+	layer_files.push_back(file_name);
+}
+
+// --- HELPER FUNCTIONS ---
+
+void Tilemap::LoadLayerFile(const std::string& file_name) {
+	const std::string base_path = "resources/tilemaps/" + file_name;
+	if (EngineUtils::CheckPathExists(base_path + ".csv")) {
+		LoadCSVLayer(base_path + ".csv");
+	}
+	else if (EngineUtils::CheckPathExists(base_path + ".tilemap")) {
+		LoadBinaryLayers(base_path + ".tilemap");
+	}
+	else {
+		std::cout << "error: tilemap layer " << file_name << " is missing";
+		exit(0);
+	}
+}
+
+void Tilemap::LoadCSVLayer(const std::string& path) {
+	std::ifstream file(path);
+	std::vector<int32_t> layer;
+	std::string line;
+	int layer_width = 0;
+	int layer_height = 0;
+	while (std::getline(file, line)) {
+		if (line.find_first_not_of(" \t\r") == std::string::npos) {
+			continue;
+		}
+		std::stringstream row(line);
+		std::string cell;
+		int row_width = 0;
+		while (std::getline(row, cell, ',')) {
+			if (cell.find_first_not_of(" \t\r") == std::string::npos) {
+				continue;
+			}
+			layer.push_back(static_cast<int32_t>(std::stoi(cell)));
+			row_width++;
+		}
+		if (layer_height == 0) {
+			layer_width = row_width;
+		}
+		else if (row_width != layer_width) {
+			std::cout << "error: tilemap " << path << " has rows of different lengths";
+			exit(0);
+		}
+		layer_height++;
+	}
+	CheckDimensions(layer_width, layer_height, path);
+	tiles.insert(tiles.end(), layer.begin(), layer.end());
+	layer_count++;
+}
+
+void Tilemap::LoadBinaryLayers(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	char magic[4] = {};
+	uint32_t header[3] = {};
+	file.read(magic, 4);
+	file.read(reinterpret_cast<char*>(header), sizeof(header));
+	if (!file || magic[0] != 'T' || magic[1] != 'M' || magic[2] != 'A' || magic[3] != 'P') {
+		std::cout << "error: tilemap " << path << " is not a valid .tilemap file";
+		exit(0);
+	}
+	CheckDimensions(static_cast<int>(header[0]), static_cast<int>(header[1]), path);
+
+	size_t count = static_cast<size_t>(header[0]) * header[1] * header[2];
+	size_t offset = tiles.size();
+	tiles.resize(offset + count);
+	file.read(reinterpret_cast<char*>(tiles.data() + offset), count * sizeof(int32_t));
+	if (!file) {
+		std::cout << "error: tilemap " << path << " is truncated";
+		exit(0);
+	}
+	layer_count += static_cast<int>(header[2]);
+}
+
+void Tilemap::CheckDimensions(int layer_width, int layer_height, const std::string& path) {
+	if (layer_count == 0) {
+		width = layer_width;
+		height = layer_height;
+	}
+	else if (layer_width != width || layer_height != height) {
+		std::cout << "error: tilemap layer " << path << " does not match the size of the first layer";
+		exit(0);
+	}
+}
+
+void Tilemap::BakeChunk(int layer, int chunk_x, int chunk_y) {
+	TilemapChunk& chunk = chunks[(static_cast<size_t>(layer) * chunks_y + chunk_y) * chunks_x + chunk_x];
+	chunk.vertices.clear();
+	chunk.dirty = false;
+
+	const float u_step = tile_width / atlas_width;
+	const float v_step = tile_height / atlas_height;
+	const SDL_Color white = { 255, 255, 255, 255 };
+
+	int start_x = chunk_x * chunk_size;
+	int start_y = chunk_y * chunk_size;
+	int end_x = std::min(width, start_x + chunk_size);
+	int end_y = std::min(height, start_y + chunk_size);
+	const int32_t* layer_tiles = tiles.data() + static_cast<size_t>(layer) * width * height;
+
+	for (int ty = start_y; ty < end_y; ty++) {
+		for (int tx = start_x; tx < end_x; tx++) {
+			int32_t tile = layer_tiles[ty * width + tx];
+			if (tile < 0 || tile >= atlas_columns * atlas_rows) {
+				continue;
+			}
+			float u = (tile % atlas_columns) * u_step;
+			float v = (tile / atlas_columns) * v_step;
+			float px = static_cast<float>(tx * tile_width);
+			float py = static_cast<float>(ty * tile_height);
+
+			// Top left, top right, bottom right, bottom left
+			chunk.vertices.push_back({ { px, py }, white, { u, v } });
+			chunk.vertices.push_back({ { px + tile_width, py }, white, { u + u_step, v } });
+			chunk.vertices.push_back({ { px + tile_width, py + tile_height }, white, { u + u_step, v + v_step } });
+			chunk.vertices.push_back({ { px, py + tile_height }, white, { u, v + v_step } });
+		}
+	}
+}
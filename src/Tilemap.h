@@ -0,0 +1,119 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "SDL2/SDL.h"
+#include "Actor.h"
+
+// A baked block of chunk_size x chunk_size tiles for a single layer.
+struct TilemapChunk {
+	// Quad vertices (4 per non-empty tile) in pixels relative to the map origin
+	std::vector<SDL_Vertex> vertices;
+
+	// Set when a tile inside the chunk changes, cleared when re-baked
+	bool dirty = true;
+};
+
+class Tilemap
+{
+public:
+	// Used to determine whether or not functions should fire in the frame
+	bool enabled = true;
+
+	// Helper reference to owner
+	Actor* actor = nullptr;
+
+	// Component variables
+	std::string key = "???";
+	std::string type = "Tilemap";
+
+	// Initial Tilemap variables
+	float x = 0.0f; // world position of the top left corner of the map
+	float y = 0.0f;
+
+	std::string atlas = ""; // image in resources/images holding the tiles
+	int tile_width = 16; // size of a single tile in the atlas, in pixels
+	int tile_height = 16;
+	int chunk_size = 16; // chunks are chunk_size x chunk_size tiles
+
+	int sorting_order = 0;
+
+	// Names of files in resources/tilemaps, .csv (one layer) or .tilemap (binary, any number of layers)
+	std::vector<std::string> layer_files;
+
+	// Sets the variables present in a component's json, leaving the rest as they are
+	void ReadValues(const rapidjson::Value& value);
+
+	// --- [ LIFE CYCLE FUNCTIONS ] ---
+
+	// Loads all layers and the atlas
+	void OnStart();
+
+	// Re-bakes dirty visible chunks and submits them to the renderer
+	void OnUpdate();
+
+	// --- [ LUA FUNCTIONS ] ---
+
+	// Returns the tile index at (tile_x, tile_y) on the first layer, or -1 if empty or out of bounds
+	int GetTile(int tile_x, int tile_y);
+
+	// Sets the tile index at (tile_x, tile_y) on the first layer, -1 clears the tile
+	void SetTile(int tile_x, int tile_y, int tile);
+
+	// Returns the tile index at (tile_x, tile_y) on [layer] (0 indexed), or -1 if empty or out of bounds
+	int GetLayerTile(int layer, int tile_x, int tile_y);
+
+	// Sets the tile index at (tile_x, tile_y) on [layer] (0 indexed), -1 clears the tile
+	void SetLayerTile(int layer, int tile_x, int tile_y, int tile);
+
+	// Returns the map width in tiles
+	int GetWidth();
+
+	// Returns the map height in tiles
+	int GetHeight();
+
+	// Returns the number of layers
+	int GetLayerCount();
+
+	// Adds a layer file for a tilemap made with AddComponent, only read by OnStart
+	void AddLayer(std::string file_name);
+
+private:
+	int width = 0;
+	int height = 0;
+	int layer_count = 0;
+
+	// Tile indices of every layer, flattened as [layer][y][x]
+	std::vector<int32_t> tiles;
+
+	int chunks_x = 0;
+	int chunks_y = 0;
+
+	// Chunks of every layer, flattened as [layer][chunk_y][chunk_x]
+	std::vector<TilemapChunk> chunks;
+
+	// Per-layer vertices of the visible chunks, kept alive until the renderer flushes them
+	std::vector<std::vector<SDL_Vertex>> visible_vertices;
+
+	SDL_Texture* atlas_texture = nullptr;
+	int atlas_columns = 1;
+	int atlas_rows = 1;
+	float atlas_width = 1.0f;
+	float atlas_height = 1.0f;
+
+	// --- [ HELPER FUNCTIONS ] ---
+
+	// Appends the layers of a .csv or .tilemap file to tiles
+	void LoadLayerFile(const std::string& file_name);
+
+	// Parses one comma separated layer
+	void LoadCSVLayer(const std::string& path);
+
+	// Parses a binary layer file: "TMAP", uint32 width, uint32 height, uint32 layers, then int32 tiles
+	void LoadBinaryLayers(const std::string& path);
+
+	// Ensures every layer shares the same dimensions
+	void CheckDimensions(int layer_width, int layer_height, const std::string& path);
+
+	// Rebuilds the vertices of one chunk from the tile array
+	void BakeChunk(int layer, int chunk_x, int chunk_y);
+};
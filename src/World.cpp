@@ -13,7 +13,7 @@ float RaycastCallback::ReportFixture(b2Fixture* fixture, const b2Vec2& point, co
 
 
 	HitResult result;
-	result.actor = a;
+	result.actor = ActorPool::GetHandle(a);
 	result.is_trigger = fixture->IsSensor();
 	result.normal = normal;
 	result.point = point;
@@ -84,6 +84,7 @@ luabridge::LuaRef World::RayCastAll(b2Vec2 pos, b2Vec2 dir, float dist) {
 World::~World() {
 	if (Exists()) {
 		delete listener;
+		delete filter;
 		delete world;
 	}
 }
@@ -106,6 +107,8 @@ void World::Instantiate(float _x, float _y) {
 	world = new b2World(gravity);
 	listener = new ContactListener();
 	world->SetContactListener(listener);
+	filter = new ContactFilter();
+	world->SetContactFilter(filter);
 }
 
 b2World* World::Get() {
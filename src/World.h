@@ -5,7 +5,7 @@
 
 // --- [ RAYCASTING ] ---
 struct HitResult {
-	Actor* actor = nullptr;
+	ActorHandle actor;
 	b2Vec2 point;
 	b2Vec2 normal;
 	bool is_trigger;
@@ -52,5 +52,6 @@ public:
 	inline static b2Vec2 gravity;
 	inline static b2World* world;
 	inline static ContactListener* listener;
+	inline static ContactFilter* filter;
 };
 